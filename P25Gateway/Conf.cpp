@@ -1,5 +1,5 @@
 /*
- *	 Copyright (C) 2015-2020,2023,2025 by Jonathan Naylor G4KLX
+ *	 Copyright (C) 2015-2020,2023,2025,2026 by Jonathan Naylor G4KLX
  *
  *	 This program is free software; you can redistribute it and/or modify
  *	 it under the terms of the GNU General Public License as published by
@@ -46,10 +46,12 @@ m_myPort(0U),
 m_debug(false),
 m_daemon(false),
 m_lookupName(),
+m_lookupImage(),
 m_lookupTime(0U),
 m_voiceEnabled(true),
 m_voiceLanguage("en_GB"),
 m_voiceDirectory(),
+m_voiceLanguages(),
 m_logDisplayLevel(0U),
 m_logMQTTLevel(0U),
 m_mqttAddress("127.0.0.1"),
@@ -60,9 +62,14 @@ m_mqttAuthEnabled(false),
 m_mqttUsername(),
 m_mqttPassword(),
 m_networkPort(0U),
+m_networkDualStack(false),
 m_networkHosts1(),
 m_networkHosts2(),
 m_networkReloadTime(0U),
+m_networkResolverThreads(8U),
+m_networkResolverTimeout(5U),
+m_networkCacheFile(),
+m_networkCacheTime(60U),
 m_networkParrotAddress("127.0.0.1"),
 m_networkParrotPort(0U),
 m_networkP252DMRAddress("127.0.0.1"),
@@ -159,6 +166,8 @@ bool CConf::read()
 		} else if (section == SECTION::ID_LOOKUP) {
 			if (::strcmp(key, "Name") == 0)
 				m_lookupName = value;
+			else if (::strcmp(key, "Image") == 0)
+				m_lookupImage = value;
 			else if (::strcmp(key, "Time") == 0)
 				m_lookupTime = (unsigned int)::atoi(value);
 		} else if (section == SECTION::VOICE) {
@@ -168,6 +177,19 @@ bool CConf::read()
 				m_voiceLanguage = value;
 			else if (::strcmp(key, "Directory") == 0)
 				m_voiceDirectory = value;
+			else if (::strcmp(key, "TalkGroups") == 0) {
+				// The language comes first, followed by the talk groups that use it
+				char* p = ::strtok(value, ",\r\n");
+				if (p != nullptr) {
+					std::string language = p;
+					p = ::strtok(nullptr, ",\r\n");
+					while (p != nullptr) {
+						unsigned int tg = (unsigned int)::atoi(p);
+						m_voiceLanguages[tg] = language;
+						p = ::strtok(nullptr, ",\r\n");
+					}
+				}
+			}
 		} else if (section == SECTION::LOG) {
 			if (::strcmp(key, "MQTTLevel") == 0)
 				m_logMQTTLevel = (unsigned int)::atoi(value);
@@ -191,12 +213,26 @@ bool CConf::read()
 		} else if (section == SECTION::NETWORK) {
 			if (::strcmp(key, "Port") == 0)
 				m_networkPort = (unsigned short)::atoi(value);
+			else if (::strcmp(key, "DualStack") == 0)
+				m_networkDualStack = ::atoi(value) == 1;
 			else if (::strcmp(key, "HostsFile1") == 0)
 				m_networkHosts1 = value;
 			else if (::strcmp(key, "HostsFile2") == 0)
 				m_networkHosts2 = value;
 			else if (::strcmp(key, "ReloadTime") == 0)
 				m_networkReloadTime = (unsigned int)::atoi(value);
+			else if (::strcmp(key, "ResolverThreads") == 0)
+				m_networkResolverThreads = (unsigned int)::atoi(value);
+			else if (::strcmp(key, "ResolverTimeout") == 0) {
+				// A timeout of zero would abandon every lookup as soon as it started
+				m_networkResolverTimeout = (unsigned int)::atoi(value);
+				if (m_networkResolverTimeout == 0U)
+					m_networkResolverTimeout = 1U;
+			}
+			else if (::strcmp(key, "CacheFile") == 0)
+				m_networkCacheFile = value;
+			else if (::strcmp(key, "CacheTime") == 0)
+				m_networkCacheTime = (unsigned int)::atoi(value);
 			else if (::strcmp(key, "ParrotAddress") == 0)
 				m_networkParrotAddress = value;
 			else if (::strcmp(key, "ParrotPort") == 0)
@@ -264,6 +300,11 @@ std::string CConf::getLookupName() const
 	return m_lookupName;
 }
 
+std::string CConf::getLookupImage() const
+{
+	return m_lookupImage;
+}
+
 unsigned int CConf::getLookupTime() const
 {
 	return m_lookupTime;
@@ -284,6 +325,11 @@ std::string CConf::getVoiceDirectory() const
 	return m_voiceDirectory;
 }
 
+std::map<unsigned int, std::string> CConf::getVoiceLanguages() const
+{
+	return m_voiceLanguages;
+}
+
 unsigned int CConf::getLogDisplayLevel() const
 {
 	return m_logDisplayLevel;
@@ -334,6 +380,11 @@ unsigned short CConf::getNetworkPort() const
 	return m_networkPort;
 }
 
+bool CConf::getNetworkDualStack() const
+{
+	return m_networkDualStack;
+}
+
 std::string CConf::getNetworkHosts1() const
 {
 	return m_networkHosts1;
@@ -349,6 +400,26 @@ unsigned int CConf::getNetworkReloadTime() const
 	return m_networkReloadTime;
 }
 
+unsigned int CConf::getNetworkResolverThreads() const
+{
+	return m_networkResolverThreads;
+}
+
+unsigned int CConf::getNetworkResolverTimeout() const
+{
+	return m_networkResolverTimeout;
+}
+
+std::string CConf::getNetworkCacheFile() const
+{
+	return m_networkCacheFile;
+}
+
+unsigned int CConf::getNetworkCacheTime() const
+{
+	return m_networkCacheTime;
+}
+
 std::string CConf::getNetworkParrotAddress() const
 {
 	return m_networkParrotAddress;
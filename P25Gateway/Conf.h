@@ -1,5 +1,5 @@
 /*
- *	 Copyright (C) 2015-2020,2023,2025 by Jonathan Naylor G4KLX
+ *	 Copyright (C) 2015-2020,2023,2025,2026 by Jonathan Naylor G4KLX
  *
  *	 This program is free software; you can redistribute it and/or modify
  *	 it under the terms of the GNU General Public License as published by
@@ -21,6 +21,7 @@
 
 #include <string>
 #include <vector>
+#include <map>
 
 class CConf
 {
@@ -40,12 +41,14 @@ public:
 
 	// The Id Lookup section
 	std::string  getLookupName() const;
+	std::string  getLookupImage() const;
 	unsigned int getLookupTime() const;
 
 	// The Voice section
 	bool         getVoiceEnabled() const;
 	std::string  getVoiceLanguage() const;
 	std::string  getVoiceDirectory() const;
+	std::map<unsigned int, std::string> getVoiceLanguages() const;
 
 	// The Log section
 	unsigned int getLogDisplayLevel() const;
@@ -62,9 +65,14 @@ public:
 
 	// The Network section
 	unsigned short getNetworkPort() const;
+	bool         getNetworkDualStack() const;
 	std::string  getNetworkHosts1() const;
 	std::string  getNetworkHosts2() const;
 	unsigned int getNetworkReloadTime() const;
+	unsigned int getNetworkResolverThreads() const;
+	unsigned int getNetworkResolverTimeout() const;
+	std::string  getNetworkCacheFile() const;
+	unsigned int getNetworkCacheTime() const;
 	std::string  getNetworkParrotAddress() const;
 	unsigned short getNetworkParrotPort() const;
 	std::string  getNetworkP252DMRAddress() const;
@@ -87,11 +95,13 @@ private:
 	bool         m_daemon;
 
 	std::string  m_lookupName;
+	std::string  m_lookupImage;
 	unsigned int m_lookupTime;
 
 	bool         m_voiceEnabled;
 	std::string  m_voiceLanguage;
 	std::string  m_voiceDirectory;
+	std::map<unsigned int, std::string> m_voiceLanguages;
 
 	unsigned int m_logDisplayLevel;
 	unsigned int m_logMQTTLevel;
@@ -105,9 +115,14 @@ private:
 	std::string  m_mqttPassword;
 
 	unsigned short m_networkPort;
+	bool         m_networkDualStack;
 	std::string  m_networkHosts1;
 	std::string  m_networkHosts2;
 	unsigned int m_networkReloadTime;
+	unsigned int m_networkResolverThreads;
+	unsigned int m_networkResolverTimeout;
+	std::string  m_networkCacheFile;
+	unsigned int m_networkCacheTime;
 	std::string  m_networkParrotAddress;
 	unsigned short m_networkParrotPort;
 	std::string  m_networkP252DMRAddress;
@@ -1,5 +1,5 @@
 /*
-*   Copyright (C) 2016,2025 by Jonathan Naylor G4KLX
+*   Copyright (C) 2016,2025,2026 by Jonathan Naylor G4KLX
 *
 *   This program is free software; you can redistribute it and/or modify
 *   it under the terms of the GNU General Public License as published by
@@ -17,21 +17,24 @@
 */
 
 #include "DMRLookup.h"
+#include "StopWatch.h"
 #include "Timer.h"
 #include "Log.h"
 
+#include <cassert>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <cctype>
 
-CDMRLookup::CDMRLookup(const std::string& filename, unsigned int reloadTime) :
+CDMRLookup::CDMRLookup(const std::string& filename, const std::string& imageName, unsigned int reloadTime) :
 CThread(),
 m_filename(filename),
+m_imageName(imageName),
 m_reloadTime(reloadTime),
 m_table(),
-m_mutex(),
-m_stop(false)
+m_watcher(),
+m_running(false)
 {
 }
 
@@ -43,8 +46,13 @@ bool CDMRLookup::read()
 {
 	bool ret = load();
 
-	if (m_reloadTime > 0U)
-		run();
+	// The file is reloaded when it changes, and also every reload time hours if set
+	if (!m_watcher.open())
+		LogWarning("Unable to watch the Id lookup file for changes");
+
+	bool watching = m_watcher.add(m_filename);
+	if (watching || (m_reloadTime > 0U))
+		m_running = run();
 
 	return ret;
 }
@@ -53,14 +61,25 @@ void CDMRLookup::entry()
 {
 	LogInfo("Started the DMR Id lookup reload thread");
 
-	CTimer timer(1U, 3600U * m_reloadTime);
-	timer.start();
+	CTimer timer(1000U, 3600U * m_reloadTime);
+	if (m_reloadTime > 0U)
+		timer.start();
+
+	CStopWatch stopWatch;
+	stopWatch.start();
+
+	for (;;) {
+		WATCH_RESULT result = m_watcher.wait(timer.getRemainingMS());
+		if (result == WATCH_RESULT::STOPPED)
+			break;
 
-	while (!m_stop) {
-		sleep(1000U);
+		timer.clock(stopWatch.elapsed());
+		stopWatch.start();
 
-		timer.clock();
-		if (timer.hasExpired()) {
+		if (result == WATCH_RESULT::CHANGED) {
+			LogInfo("The Id lookup file has changed");
+			load();
+		} else if (timer.isRunning() && timer.hasExpired()) {
 			load();
 			timer.start();
 		}
@@ -71,51 +90,84 @@ void CDMRLookup::entry()
 
 void CDMRLookup::stop()
 {
-	if (m_reloadTime == 0U) {
-		delete this;
-		return;
+	if (m_running) {
+		m_watcher.stop();
+		wait();
 	}
 
-	m_stop = true;
-
-	wait();
+	delete this;
 }
 
 std::string CDMRLookup::find(unsigned int id)
 {
-	std::string callsign;
-
 	if (id == 0xFFFFFFU)
 		return std::string("ALL");
 
-	m_mutex.lock();
-
-	try {
-		callsign = m_table.at(id);
-	} catch (...) {
-		char text[10U];
-		::sprintf(text, "%u", id);
-		callsign = std::string(text);
+	// Never blocks, a reload only ever swaps in a complete new table
+	std::shared_ptr<const CDMRTable> table = std::atomic_load(&m_table);
+	if (table != nullptr) {
+		const char* callsign = table->find(id);
+		if (callsign != nullptr)
+			return std::string(callsign);
 	}
 
-	m_mutex.unlock();
+	char text[10U];
+	::sprintf(text, "%u", id);
+
+	return std::string(text);
+}
+
+bool CDMRLookup::find(unsigned int id, std::string& callsign, std::string& name)
+{
+	std::shared_ptr<const CDMRTable> table = std::atomic_load(&m_table);
+	if (table == nullptr)
+		return false;
+
+	const char* p1 = table->find(id);
+	const char* p2 = table->findName(id);
+	if (p1 == nullptr || p2 == nullptr)
+		return false;
+
+	callsign = p1;
+	name     = p2;
+
+	return true;
+}
+
+std::vector<unsigned int> CDMRLookup::findIds(const std::string& callsign)
+{
+	std::vector<unsigned int> ids;
+
+	std::string text = callsign;
+	for (auto& c : text)
+		c = ::toupper(c);
+
+	std::shared_ptr<const CDMRTable> table = std::atomic_load(&m_table);
+	if (table != nullptr)
+		table->findIds(text.c_str(), ids);
 
-	return callsign;
+	return ids;
 }
 
 bool CDMRLookup::load()
 {
+	// Build the new table off to the side, lookups continue to use the old one
+	CDMRTable* table = new CDMRTable;
+
+	// An up to date image is mapped in place of parsing the text file
+	if (!m_imageName.empty() && table->map(m_imageName, m_filename)) {
+		LogInfo("Mapped %u Ids from the callsign lookup image", table->size());
+		publish(table);
+		return true;
+	}
+
 	FILE* fp = ::fopen(m_filename.c_str(), "rt");
 	if (fp == nullptr) {
 		LogWarning("Cannot open the Id lookup file - %s", m_filename.c_str());
+		delete table;
 		return false;
 	}
 
-	m_mutex.lock();
-
-	// Remove the old entries
-	m_table.clear();
-
 	char buffer[100U];
 	while (::fgets(buffer, 100U, fp) != nullptr) {
 		if (buffer[0U] == '#')
@@ -123,25 +175,46 @@ bool CDMRLookup::load()
 
 		char* p1 = ::strtok(buffer, " \t\r\n");
 		char* p2 = ::strtok(nullptr, " \t\r\n");
+		char* p3 = ::strtok(nullptr, "\t\r\n");
 
 		if (p1 != nullptr && p2 != nullptr) {
 			unsigned int id = (unsigned int)::atoi(p1);
 			for (char* p = p2; *p != 0x00U; p++)
 				*p = ::toupper(*p);
 
-			m_table[id] = std::string(p2);
+			// The name may contain spaces, so only a tab ends it
+			if (p3 != nullptr) {
+				while (*p3 == ' ')
+					p3++;
+			}
+
+			table->add(id, p2, p3 != nullptr ? p3 : "");
 		}
 	}
 
-	m_mutex.unlock();
-
 	::fclose(fp);
 
-	size_t size = m_table.size();
-	if (size == 0U)
+	table->finalise();
+
+	unsigned int size = table->size();
+	if (size == 0U) {
+		delete table;
 		return false;
+	}
+
+	if (!m_imageName.empty() && table->save(m_imageName, m_filename))
+		LogInfo("Compiled the callsign lookup image %s", m_imageName.c_str());
+
+	publish(table);
 
 	LogInfo("Loaded %u Ids to the callsign lookup table", size);
 
 	return true;
+}
+
+void CDMRLookup::publish(CDMRTable* table)
+{
+	assert(table != nullptr);
+
+	std::atomic_store(&m_table, std::shared_ptr<const CDMRTable>(table));
 }
\ No newline at end of file
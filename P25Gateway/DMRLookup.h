@@ -1,5 +1,5 @@
 /*
-*   Copyright (C) 2016 by Jonathan Naylor G4KLX
+*   Copyright (C) 2016,2026 by Jonathan Naylor G4KLX
 *
 *   This program is free software; you can redistribute it and/or modify
 *   it under the terms of the GNU General Public License as published by
@@ -19,15 +19,17 @@
 #ifndef	DMRLookup_H
 #define	DMRLookup_H
 
+#include "FileWatcher.h"
+#include "DMRTable.h"
 #include "Thread.h"
-#include "Mutex.h"
 
 #include <string>
-#include <unordered_map>
+#include <vector>
+#include <memory>
 
 class CDMRLookup : public CThread {
 public:
-	CDMRLookup(const std::string& filename, unsigned int reloadTime);
+	CDMRLookup(const std::string& filename, const std::string& imageName, unsigned int reloadTime);
 	virtual ~CDMRLookup();
 
 	bool read();
@@ -35,17 +37,22 @@ public:
 	virtual void entry();
 
 	std::string find(unsigned int id);
+	bool        find(unsigned int id, std::string& callsign, std::string& name);
+
+	std::vector<unsigned int> findIds(const std::string& callsign);
 
 	void stop();
 
 private:
 	std::string                                   m_filename;
+	std::string                                   m_imageName;
 	unsigned int                                  m_reloadTime;
-	std::unordered_map<unsigned int, std::string> m_table;
-	CMutex                                        m_mutex;
-	bool                                          m_stop;
+	std::shared_ptr<const CDMRTable>              m_table;
+	CFileWatcher                                  m_watcher;
+	bool                                          m_running;
 
 	bool load();
+	void publish(CDMRTable* table);
 };
 
 #endif
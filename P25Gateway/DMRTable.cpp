@@ -0,0 +1,341 @@
+/*
+ *   Copyright (C) 2026 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "DMRTable.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+const uint32_t IMAGE_MAGIC   = 0x44353250U;		// "P25D"
+const uint32_t IMAGE_VERSION = 2U;
+
+struct CDMRImageHeader {
+	uint32_t m_magic;
+	uint32_t m_version;
+	uint32_t m_count;
+	uint32_t m_stringsSize;
+	uint64_t m_sourceTime;
+	uint64_t m_sourceSize;
+	uint32_t m_checksum;
+	uint32_t m_reserved;
+};
+
+static uint32_t checksum(uint32_t hash, const void* data, size_t length)
+{
+	// 32-bit FNV-1a
+	const unsigned char* p = (const unsigned char*)data;
+	for (size_t i = 0U; i < length; i++)
+		hash = (hash ^ p[i]) * 0x01000193U;
+
+	return hash;
+}
+
+static bool sourceInfo(const std::string& sourceName, uint64_t& time, uint64_t& size)
+{
+	struct stat st;
+	if (::stat(sourceName.c_str(), &st) != 0)
+		return false;
+
+	time = uint64_t(st.st_mtime);
+	size = uint64_t(st.st_size);
+
+	return true;
+}
+
+CDMRTable::CDMRTable() :
+m_entries(),
+m_callsigns(),
+m_arena(),
+m_index(nullptr),
+m_byCallsign(nullptr),
+m_count(0U),
+m_strings(nullptr),
+m_stringsSize(0U),
+m_map(nullptr),
+m_mapSize(0U)
+{
+}
+
+CDMRTable::~CDMRTable()
+{
+	unmap();
+}
+
+void CDMRTable::add(unsigned int id, const char* callsign, const char* name)
+{
+	CDMREntry entry;
+	entry.m_id     = id;
+	entry.m_offset = uint32_t(m_arena.size());
+	m_entries.push_back(entry);
+
+	// The name follows straight after the callsign, so one offset finds both
+	m_arena.insert(m_arena.end(), callsign, callsign + ::strlen(callsign) + 1U);
+	m_arena.insert(m_arena.end(), name, name + ::strlen(name) + 1U);
+}
+
+void CDMRTable::finalise()
+{
+	// A stable sort keeps duplicates in file order, and the last one is
+	// kept, as happened when the file was read into a map
+	std::stable_sort(m_entries.begin(), m_entries.end(), [](const CDMREntry& a, const CDMREntry& b) { return a.m_id < b.m_id; });
+
+	std::vector<CDMREntry>::iterator out = m_entries.begin();
+	for (std::vector<CDMREntry>::const_iterator it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+		if ((out != m_entries.begin()) && ((out - 1)->m_id == it->m_id))
+			*(out - 1) = *it;
+		else
+			*out++ = *it;
+	}
+	m_entries.erase(out, m_entries.end());
+
+	m_entries.shrink_to_fit();
+	m_arena.shrink_to_fit();
+
+	// Entries with the same callsign stay in Id order
+	m_callsigns.resize(m_entries.size());
+	for (uint32_t i = 0U; i < m_callsigns.size(); i++)
+		m_callsigns[i] = i;
+
+	const char* strings = m_arena.data();
+	std::stable_sort(m_callsigns.begin(), m_callsigns.end(), [this, strings](uint32_t a, uint32_t b) { return ::strcmp(strings + m_entries[a].m_offset, strings + m_entries[b].m_offset) < 0; });
+
+	m_index       = m_entries.data();
+	m_byCallsign  = m_callsigns.data();
+	m_count       = (unsigned int)m_entries.size();
+	m_strings     = m_arena.data();
+	m_stringsSize = (unsigned int)m_arena.size();
+}
+
+bool CDMRTable::save(const std::string& imageName, const std::string& sourceName) const
+{
+	CDMRImageHeader header;
+	::memset(&header, 0x00U, sizeof(CDMRImageHeader));
+	header.m_magic       = IMAGE_MAGIC;
+	header.m_version     = IMAGE_VERSION;
+	header.m_count       = m_count;
+	header.m_stringsSize = m_stringsSize;
+
+	sourceInfo(sourceName, header.m_sourceTime, header.m_sourceSize);
+
+	uint32_t hash = 0x811C9DC5U;
+	hash = checksum(hash, m_index, m_count * sizeof(CDMREntry));
+	hash = checksum(hash, m_byCallsign, m_count * sizeof(uint32_t));
+	hash = checksum(hash, m_strings, m_stringsSize);
+	header.m_checksum = hash;
+
+	// Write to a temporary file and rename it, so that a process with the old image mapped keeps it intact
+	std::string tempName = imageName + ".tmp";
+
+	FILE* fp = ::fopen(tempName.c_str(), "wb");
+	if (fp == nullptr) {
+		LogWarning("Unable to write the Id lookup image - %s", tempName.c_str());
+		return false;
+	}
+
+	bool ok = ::fwrite(&header, sizeof(CDMRImageHeader), 1U, fp) == 1U;
+	ok = ok && (::fwrite(m_index, sizeof(CDMREntry), m_count, fp) == m_count);
+	ok = ok && (::fwrite(m_byCallsign, sizeof(uint32_t), m_count, fp) == m_count);
+	ok = ok && (::fwrite(m_strings, 1U, m_stringsSize, fp) == m_stringsSize);
+	ok = (::fclose(fp) == 0) && ok;
+
+#if defined(_WIN32) || defined(_WIN64)
+	if (ok)
+		::remove(imageName.c_str());
+#endif
+
+	if (!ok || (::rename(tempName.c_str(), imageName.c_str()) != 0)) {
+		LogWarning("Unable to write the Id lookup image - %s", imageName.c_str());
+		::remove(tempName.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+bool CDMRTable::map(const std::string& imageName, const std::string& sourceName)
+{
+	unmap();
+
+#if defined(_WIN32) || defined(_WIN64)
+	HANDLE file = ::CreateFileA(imageName.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!::GetFileSizeEx(file, &fileSize) || (uint64_t(fileSize.QuadPart) < sizeof(CDMRImageHeader))) {
+		::CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = ::CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	::CloseHandle(file);
+	if (mapping == NULL)
+		return false;
+
+	// The view keeps the mapping alive after its handle is closed
+	m_map = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	::CloseHandle(mapping);
+	if (m_map == NULL) {
+		m_map = nullptr;
+		return false;
+	}
+
+	m_mapSize = size_t(fileSize.QuadPart);
+#else
+	int fd = ::open(imageName.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd == -1)
+		return false;
+
+	struct stat st;
+	if ((::fstat(fd, &st) != 0) || (uint64_t(st.st_size) < sizeof(CDMRImageHeader))) {
+		::close(fd);
+		return false;
+	}
+
+	void* map = ::mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (map == MAP_FAILED)
+		return false;
+
+	m_map     = map;
+	m_mapSize = size_t(st.st_size);
+#endif
+
+	const CDMRImageHeader* header = (const CDMRImageHeader*)m_map;
+	if ((header->m_magic != IMAGE_MAGIC) || (header->m_version != IMAGE_VERSION) ||
+	    (m_mapSize != (sizeof(CDMRImageHeader) + uint64_t(header->m_count) * (sizeof(CDMREntry) + sizeof(uint32_t)) + header->m_stringsSize))) {
+		LogWarning("The Id lookup image %s is invalid", imageName.c_str());
+		unmap();
+		return false;
+	}
+
+	// A missing text file leaves the image as the best copy there is
+	uint64_t sourceTime, sourceSize;
+	if (sourceInfo(sourceName, sourceTime, sourceSize) && ((sourceTime != header->m_sourceTime) || (sourceSize != header->m_sourceSize))) {
+		LogInfo("The Id lookup image %s is older than %s", imageName.c_str(), sourceName.c_str());
+		unmap();
+		return false;
+	}
+
+	const unsigned char* data = (const unsigned char*)m_map + sizeof(CDMRImageHeader);
+	size_t dataSize = m_mapSize - sizeof(CDMRImageHeader);
+
+	if (checksum(0x811C9DC5U, data, dataSize) != header->m_checksum) {
+		LogWarning("The Id lookup image %s has a bad checksum", imageName.c_str());
+		unmap();
+		return false;
+	}
+
+	m_index       = (const CDMREntry*)data;
+	m_count       = header->m_count;
+	m_byCallsign  = (const uint32_t*)(data + m_count * sizeof(CDMREntry));
+	m_strings     = (const char*)(data + m_count * (sizeof(CDMREntry) + sizeof(uint32_t)));
+	m_stringsSize = header->m_stringsSize;
+
+	return true;
+}
+
+const char* CDMRTable::find(unsigned int id) const
+{
+	const CDMREntry* entry = lookup(id);
+	if (entry == nullptr)
+		return nullptr;
+
+	return m_strings + entry->m_offset;
+}
+
+const char* CDMRTable::findName(unsigned int id) const
+{
+	const CDMREntry* entry = lookup(id);
+	if (entry == nullptr)
+		return nullptr;
+
+	const char* callsign = m_strings + entry->m_offset;
+	size_t length = ::strnlen(callsign, m_stringsSize - entry->m_offset);
+	if ((entry->m_offset + length + 1U) >= m_stringsSize)
+		return nullptr;
+
+	return callsign + length + 1U;
+}
+
+void CDMRTable::findIds(const char* callsign, std::vector<unsigned int>& ids) const
+{
+	assert(callsign != nullptr);
+
+	ids.clear();
+
+	const uint32_t* end = m_byCallsign + m_count;
+
+	const uint32_t* it = std::lower_bound(m_byCallsign, end, callsign, [this](uint32_t n, const char* callsign) { return (n < m_count) && (::strcmp(m_strings + m_index[n].m_offset, callsign) < 0); });
+	for (; it != end; ++it) {
+		if ((*it >= m_count) || (::strcmp(m_strings + m_index[*it].m_offset, callsign) != 0))
+			break;
+
+		ids.push_back(m_index[*it].m_id);
+	}
+}
+
+unsigned int CDMRTable::size() const
+{
+	return m_count;
+}
+
+const CDMRTable::CDMREntry* CDMRTable::lookup(unsigned int id) const
+{
+	const CDMREntry* end = m_index + m_count;
+
+	const CDMREntry* it = std::lower_bound(m_index, end, id, [](const CDMREntry& entry, unsigned int id) { return entry.m_id < id; });
+	if ((it == end) || (it->m_id != id) || (it->m_offset >= m_stringsSize))
+		return nullptr;
+
+	return it;
+}
+
+void CDMRTable::unmap()
+{
+	if (m_map == nullptr)
+		return;
+
+#if defined(_WIN32) || defined(_WIN64)
+	::UnmapViewOfFile(m_map);
+#else
+	::munmap(m_map, m_mapSize);
+#endif
+
+	m_map         = nullptr;
+	m_mapSize     = 0U;
+	m_index       = nullptr;
+	m_byCallsign  = nullptr;
+	m_count       = 0U;
+	m_strings     = nullptr;
+	m_stringsSize = 0U;
+}
@@ -0,0 +1,77 @@
+/*
+ *   Copyright (C) 2026 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef	DMRTable_H
+#define	DMRTable_H
+
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+// The DMR Id to callsign table, held as an array of (id, offset) pairs
+// sorted by id and one arena of NUL terminated callsign and name pairs.
+// A second array of entry numbers sorted by callsign gives the reverse
+// lookup. The same layout is saved as a binary image that can be mapped
+// straight back in, shared by every process on the host that uses it.
+class CDMRTable {
+public:
+	CDMRTable();
+	~CDMRTable();
+
+	void add(unsigned int id, const char* callsign, const char* name);
+
+	// Sorts the entries and builds the callsign index, must be called before find() or save()
+	void finalise();
+
+	// The image records the size and time of the text file it was built from
+	bool save(const std::string& imageName, const std::string& sourceName) const;
+
+	// Fails if the image is invalid or older than the text file
+	bool map(const std::string& imageName, const std::string& sourceName);
+
+	const char* find(unsigned int id) const;
+	const char* findName(unsigned int id) const;
+
+	// All of the Ids registered to the callsign, in Id order
+	void findIds(const char* callsign, std::vector<unsigned int>& ids) const;
+
+	unsigned int size() const;
+
+private:
+	struct CDMREntry {
+		uint32_t m_id;
+		uint32_t m_offset;
+	};
+
+	std::vector<CDMREntry> m_entries;
+	std::vector<uint32_t>  m_callsigns;
+	std::vector<char>      m_arena;
+	const CDMREntry*       m_index;
+	const uint32_t*        m_byCallsign;
+	unsigned int           m_count;
+	const char*            m_strings;
+	unsigned int           m_stringsSize;
+	void*                  m_map;
+	size_t                 m_mapSize;
+
+	const CDMREntry* lookup(unsigned int id) const;
+	void unmap();
+};
+
+#endif
@@ -0,0 +1,274 @@
+/*
+ *   Copyright (C) 2026 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "FileWatcher.h"
+#include "Thread.h"
+#include "Timer.h"
+#include "Log.h"
+
+#include <cassert>
+
+// How often a plain sleep checks whether it has been stopped
+const unsigned int WATCH_SLEEP_MS = 100U;
+
+WATCH_RESULT CFileWatcher::sleep(unsigned int ms)
+{
+	for (;;) {
+		if (m_stopped)
+			return WATCH_RESULT::STOPPED;
+
+		if (ms == 0U)
+			return WATCH_RESULT::TIMEOUT;
+
+		unsigned int slice = (ms < WATCH_SLEEP_MS) ? ms : WATCH_SLEEP_MS;
+		CThread::sleep(slice);
+
+		if (ms != NO_TIMEOUT)
+			ms -= slice;
+	}
+}
+
+#if defined(_WIN32) || defined(_WIN64)
+
+CFileWatcher::CFileWatcher() :
+m_stopped(false),
+m_stopEvent(NULL)
+{
+}
+
+CFileWatcher::~CFileWatcher()
+{
+	close();
+}
+
+bool CFileWatcher::open()
+{
+	m_stopEvent = ::CreateEvent(NULL, TRUE, FALSE, NULL);
+
+	return m_stopEvent != NULL;
+}
+
+bool CFileWatcher::add(const std::string&)
+{
+	return false;
+}
+
+WATCH_RESULT CFileWatcher::wait(unsigned int ms)
+{
+	if (m_stopEvent == NULL)
+		return sleep(ms);
+
+	DWORD ret = ::WaitForSingleObject(m_stopEvent, ms == NO_TIMEOUT ? INFINITE : DWORD(ms));
+
+	return (ret == WAIT_OBJECT_0) ? WATCH_RESULT::STOPPED : WATCH_RESULT::TIMEOUT;
+}
+
+void CFileWatcher::stop()
+{
+	m_stopped = true;
+
+	if (m_stopEvent != NULL)
+		::SetEvent(m_stopEvent);
+}
+
+void CFileWatcher::close()
+{
+	if (m_stopEvent != NULL) {
+		::CloseHandle(m_stopEvent);
+		m_stopEvent = NULL;
+	}
+}
+
+#else
+
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cerrno>
+
+// A file is read once it has been closed or renamed into place and left alone for this long
+const unsigned int WATCH_SETTLE_MS = 500U;
+
+// A writer that modifies a file without closing it is given this long before the file is read anyway
+const unsigned int WATCH_WRITE_MS = 10000U;
+
+CFileWatcher::CFileWatcher() :
+m_stopped(false),
+m_inotifyFd(-1),
+m_stopFd(-1),
+m_watches(),
+m_pending(false),
+m_settle()
+{
+}
+
+CFileWatcher::~CFileWatcher()
+{
+	close();
+}
+
+bool CFileWatcher::open()
+{
+	assert(m_inotifyFd == -1);
+
+	m_stopFd = ::eventfd(0U, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (m_stopFd == -1) {
+		LogError("Cannot create the file watcher event, err: %d", errno);
+		return false;
+	}
+
+	m_inotifyFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (m_inotifyFd == -1)
+		LogWarning("Cannot create the inotify instance, err: %d", errno);
+
+	return true;
+}
+
+bool CFileWatcher::add(const std::string& fileName)
+{
+	if (m_inotifyFd == -1 || fileName.empty())
+		return false;
+
+	std::string directory = ".";
+	std::string name      = fileName;
+
+	std::string::size_type pos = fileName.find_last_of('/');
+	if (pos != std::string::npos) {
+		directory = (pos == 0U) ? "/" : fileName.substr(0U, pos);
+		name      = fileName.substr(pos + 1U);
+	}
+
+	int wd = ::inotify_add_watch(m_inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_MODIFY | IN_DELETE);
+	if (wd == -1) {
+		LogWarning("Cannot watch %s for changes, err: %d", directory.c_str(), errno);
+		return false;
+	}
+
+	CWatch watch;
+	watch.m_wd   = wd;
+	watch.m_name = name;
+	m_watches.push_back(watch);
+
+	return true;
+}
+
+WATCH_RESULT CFileWatcher::wait(unsigned int ms)
+{
+	if ((m_stopFd == -1) || m_watches.empty())
+		return sleep(ms);
+
+	std::chrono::steady_clock::time_point now     = std::chrono::steady_clock::now();
+	std::chrono::steady_clock::time_point timeout = now + std::chrono::milliseconds(ms);
+
+	for (;;) {
+		if (m_pending && (now >= m_settle)) {
+			m_pending = false;
+			return WATCH_RESULT::CHANGED;
+		}
+
+		if ((ms != NO_TIMEOUT) && (now >= timeout))
+			return WATCH_RESULT::TIMEOUT;
+
+		// Wake for whichever comes first, a change settling or the timeout, rounded up to a whole millisecond
+		std::chrono::steady_clock::time_point wake = timeout;
+		if (m_pending && ((ms == NO_TIMEOUT) || (m_settle < timeout)))
+			wake = m_settle;
+
+		int waitMS = -1;
+		if (m_pending || (ms != NO_TIMEOUT))
+			waitMS = int((std::chrono::duration_cast<std::chrono::microseconds>(wake - now).count() + 999) / 1000);
+
+		struct pollfd pfds[2U];
+		pfds[0U].fd      = m_stopFd;
+		pfds[0U].events  = POLLIN;
+		pfds[0U].revents = 0;
+		pfds[1U].fd      = m_inotifyFd;
+		pfds[1U].events  = POLLIN;
+		pfds[1U].revents = 0;
+
+		int ret = ::poll(pfds, 2U, waitMS);
+		if ((ret < 0) && (errno != EINTR)) {
+			LogError("Error returned from poll, err: %d", errno);
+			return WATCH_RESULT::STOPPED;
+		}
+
+		if (pfds[0U].revents & POLLIN)
+			return WATCH_RESULT::STOPPED;
+
+		now = std::chrono::steady_clock::now();
+
+		if (pfds[1U].revents & POLLIN) {
+			alignas(struct inotify_event) char buffer[4096U];
+
+			ssize_t len;
+			while ((len = ::read(m_inotifyFd, buffer, sizeof(buffer))) > 0) {
+				for (char* p = buffer; p < (buffer + len); p += sizeof(struct inotify_event) + ((struct inotify_event*)p)->len) {
+					const struct inotify_event* event = (const struct inotify_event*)p;
+					if (event->len == 0U)
+						continue;
+
+					for (const auto& watch : m_watches) {
+						if ((watch.m_wd == event->wd) && (watch.m_name == event->name)) {
+							// A finished write settles quickly, one still being written is read by a fixed time
+							// however often it is modified, later events only ever bring that time forward
+							bool finished = (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE)) != 0U;
+							std::chrono::steady_clock::time_point settle = now + std::chrono::milliseconds(finished ? WATCH_SETTLE_MS : WATCH_WRITE_MS);
+							if (!m_pending || (settle < m_settle))
+								m_settle = settle;
+							m_pending = true;
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+void CFileWatcher::stop()
+{
+	m_stopped = true;
+
+	if (m_stopFd == -1)
+		return;
+
+	uint64_t value = 1U;
+	ssize_t n = ::write(m_stopFd, &value, sizeof(uint64_t));
+	(void)n;
+}
+
+void CFileWatcher::close()
+{
+	if (m_inotifyFd != -1) {
+		::close(m_inotifyFd);
+		m_inotifyFd = -1;
+	}
+
+	if (m_stopFd != -1) {
+		::close(m_stopFd);
+		m_stopFd = -1;
+	}
+
+	m_watches.clear();
+	m_pending = false;
+}
+
+#endif
@@ -0,0 +1,85 @@
+/*
+ *   Copyright (C) 2026 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef	FileWatcher_H
+#define	FileWatcher_H
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#else
+#include <chrono>
+#endif
+
+#include <string>
+#include <vector>
+#include <atomic>
+
+enum class WATCH_RESULT {
+	CHANGED,
+	TIMEOUT,
+	STOPPED
+};
+
+// Waits for files to change. The directory holding each file is watched
+// with inotify, so files replaced by a rename are seen as well as those
+// rewritten in place, and a change is only reported once the writer has
+// finished. On Windows, or if open() fails, no changes are seen and wait()
+// only times out or is stopped.
+class CFileWatcher {
+public:
+	CFileWatcher();
+	~CFileWatcher();
+
+	bool open();
+
+	// Returns false if changes to the file cannot be watched
+	bool add(const std::string& fileName);
+
+	// A timeout of NO_TIMEOUT waits until a change or stop()
+	WATCH_RESULT wait(unsigned int ms);
+
+	// Wakes wait() from another thread, and every later call returns at once
+	void stop();
+
+	void close();
+
+private:
+	std::atomic<bool> m_stopped;
+
+	// Used when there is nothing to wait on but the timeout
+	WATCH_RESULT sleep(unsigned int ms);
+
+#if defined(_WIN32) || defined(_WIN64)
+	HANDLE m_stopEvent;
+#else
+	struct CWatch {
+		int         m_wd;
+		std::string m_name;
+	};
+
+	int                 m_inotifyFd;
+	int                 m_stopFd;
+	std::vector<CWatch> m_watches;
+
+	// A change is remembered across calls to wait() until it has settled
+	bool                                  m_pending;
+	std::chrono::steady_clock::time_point m_settle;
+#endif
+};
+
+#endif
@@ -0,0 +1,144 @@
+/*
+ *   Copyright (C) 2026 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "FrameClock.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#include <chrono>
+#else
+#include <ctime>
+#include <cerrno>
+#endif
+
+CFrameClock::CFrameClock(unsigned int periodMS) :
+m_period(uint64_t(periodMS) * 1000000ULL),
+m_deadline(0U),
+m_running(false),
+m_frames(0U),
+m_totalLateness(0U),
+m_maxLateness(0U)
+{
+}
+
+CFrameClock::~CFrameClock()
+{
+}
+
+void CFrameClock::start()
+{
+	m_deadline      = now();
+	m_running       = true;
+	m_frames        = 0U;
+	m_totalLateness = 0U;
+	m_maxLateness   = 0U;
+}
+
+void CFrameClock::stop()
+{
+	m_running = false;
+}
+
+bool CFrameClock::isRunning() const
+{
+	return m_running;
+}
+
+bool CFrameClock::isDue() const
+{
+	return m_running && (now() >= m_deadline);
+}
+
+void CFrameClock::tick()
+{
+	uint64_t time = now();
+
+	if (time > m_deadline) {
+		uint64_t lateness = time - m_deadline;
+		m_totalLateness += lateness;
+		if (lateness > m_maxLateness)
+			m_maxLateness = lateness;
+	}
+
+	m_frames++;
+
+	m_deadline += m_period;
+}
+
+uint64_t CFrameClock::getDeadline() const
+{
+	return m_running ? m_deadline : 0U;
+}
+
+unsigned int CFrameClock::getFrames() const
+{
+	return m_frames;
+}
+
+unsigned int CFrameClock::getMeanJitter() const
+{
+	if (m_frames == 0U)
+		return 0U;
+
+	return (unsigned int)(m_totalLateness / m_frames / 1000U);
+}
+
+unsigned int CFrameClock::getMaxJitter() const
+{
+	return (unsigned int)(m_maxLateness / 1000U);
+}
+
+#if defined(_WIN32) || defined(_WIN64)
+
+uint64_t CFrameClock::now()
+{
+	return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void CFrameClock::sleepUntil(uint64_t deadline)
+{
+	uint64_t time = now();
+	if (deadline <= time)
+		return;
+
+	// Round up, waking early would only mean sleeping again
+	::Sleep(DWORD((deadline - time + 999999ULL) / 1000000ULL));
+}
+
+#else
+
+uint64_t CFrameClock::now()
+{
+	struct timespec ts;
+	::clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return uint64_t(ts.tv_sec) * 1000000000ULL + uint64_t(ts.tv_nsec);
+}
+
+void CFrameClock::sleepUntil(uint64_t deadline)
+{
+	struct timespec ts;
+	ts.tv_sec  = time_t(deadline / 1000000000ULL);
+	ts.tv_nsec = long(deadline % 1000000000ULL);
+
+	// An absolute wake up time cannot drift however often the sleep is interrupted
+	while (::clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+		;
+}
+
+#endif
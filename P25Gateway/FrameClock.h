@@ -0,0 +1,67 @@
+/*
+ *   Copyright (C) 2026 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(FrameClock_H)
+#define	FrameClock_H
+
+#include <cstdint>
+
+// Paces a stream of frames against absolute deadlines on the monotonic
+// clock, in nanoseconds. Each deadline is one period after the last, so
+// lateness in sending one frame never pushes back the ones after it. How
+// late each frame was sent is kept as a measure of the jitter.
+class CFrameClock {
+public:
+	CFrameClock(unsigned int periodMS);
+	~CFrameClock();
+
+	// The first frame is due straight away
+	void start();
+	void stop();
+
+	bool isRunning() const;
+
+	// True when the next frame should be sent
+	bool isDue() const;
+
+	// Called as each frame is sent, moves on to the next deadline
+	void tick();
+
+	// When the next frame is due, zero if not running
+	uint64_t getDeadline() const;
+
+	unsigned int getFrames() const;
+	unsigned int getMeanJitter() const;		// in microseconds
+	unsigned int getMaxJitter() const;		// in microseconds
+
+	// The monotonic clock in nanoseconds, the same clock as CLOCK_MONOTONIC on Linux
+	static uint64_t now();
+
+	// Sleeps until the given time on the monotonic clock
+	static void sleepUntil(uint64_t deadline);
+
+private:
+	uint64_t     m_period;
+	uint64_t     m_deadline;
+	bool         m_running;
+	unsigned int m_frames;
+	uint64_t     m_totalLateness;
+	uint64_t     m_maxLateness;
+};
+
+#endif
@@ -0,0 +1 @@
+const char *gitversion = "80164a60a5a57f4d7d85219e38bd245051e76d18";
@@ -1,5 +1,5 @@
 /*
-*   Copyright (C) 2016-2025 by Jonathan Naylor G4KLX
+*   Copyright (C) 2016-2026 by Jonathan Naylor G4KLX
 *
 *   This program is free software; you can redistribute it and/or modify
 *   it under the terms of the GNU General Public License as published by
@@ -21,6 +21,7 @@
 #include "RptNetwork.h"
 #include "StopWatch.h"
 #include "DMRLookup.h"
+#include "Poller.h"
 #include "Version.h"
 #include "Thread.h"
 #include "Utils.h"
@@ -72,6 +73,7 @@ const unsigned P25_VOICE_ID = 10999U;
 #include <cstdarg>
 #include <ctime>
 #include <cstring>
+#include <algorithm>
 
 
 int main(int argc, char** argv)
@@ -138,10 +140,15 @@ m_voice(nullptr),
 m_remoteNetwork(nullptr),
 m_staticTGs(),
 m_currentTG(),
+m_sources(),
 m_currentIsStatic(false),
 m_hangTimer(1000U),
 m_rfHangTime(0U),
-m_reflectors(nullptr)
+m_reflectors(nullptr),
+m_lookup(nullptr),
+m_poller(),
+m_mutex(),
+m_commands()
 {
 	CUDPSocket::startup();
 }
@@ -244,7 +251,7 @@ int CP25Gateway::run()
 	if (!ret)
 		return 1;
 
-	m_remoteNetwork = new CP25Network(m_conf.getNetworkPort(), m_conf.getCallsign(), m_conf.getNetworkDebug());
+	m_remoteNetwork = new CP25Network(m_conf.getNetworkPort(), m_conf.getCallsign(), m_conf.getNetworkDualStack(), m_conf.getNetworkDebug());
 	ret = m_remoteNetwork->open();
 	if (!ret) {
 		delete m_remoteNetwork;
@@ -252,15 +259,30 @@ int CP25Gateway::run()
 		return 1;
 	}
 
-	m_reflectors = new CReflectors(m_conf.getNetworkHosts1(), m_conf.getNetworkHosts2(), m_conf.getNetworkReloadTime());
+	ret = m_poller.open();
+	if (ret)
+		ret = localNetwork.registerSockets(m_poller) && m_remoteNetwork->registerSockets(m_poller);
+	if (!ret) {
+		LogError("Unable to wait on the network sockets");
+		m_poller.close();
+		m_remoteNetwork->close();
+		delete m_remoteNetwork;
+		localNetwork.close();
+		return 1;
+	}
+
+	m_reflectors = new CReflectors(m_conf.getNetworkHosts1(), m_conf.getNetworkHosts2(), m_conf.getNetworkReloadTime(), m_conf.getNetworkResolverThreads(), m_conf.getNetworkResolverTimeout());
 	if (m_conf.getNetworkParrotPort() > 0U)
 		m_reflectors->setParrot(m_conf.getNetworkParrotAddress(), m_conf.getNetworkParrotPort());
 	if (m_conf.getNetworkP252DMRPort() > 0U)
 		m_reflectors->setP252DMR(m_conf.getNetworkP252DMRAddress(), m_conf.getNetworkP252DMRPort());
+	if (!m_conf.getNetworkCacheFile().empty())
+		m_reflectors->setCache(m_conf.getNetworkCacheFile(), m_conf.getNetworkCacheTime());
 	m_reflectors->load();
+	m_reflectors->start();
 
-	CDMRLookup* lookup = new CDMRLookup(m_conf.getLookupName(), m_conf.getLookupTime());
-	lookup->read();
+	m_lookup = new CDMRLookup(m_conf.getLookupName(), m_conf.getLookupImage(), m_conf.getLookupTime());
+	m_lookup->read();
 
 	m_rfHangTime = m_conf.getNetworkRFHangTime();
 	unsigned int netHangTime = m_conf.getNetworkNetHangTime();
@@ -277,6 +299,10 @@ int CP25Gateway::run()
 		if (!ok) {
 			delete m_voice;
 			m_voice = nullptr;
+		} else {
+			std::map<unsigned int, std::string> languages = m_conf.getVoiceLanguages();
+			for (const auto& it : languages)
+				m_voice->setLanguage(it.first, it.second);
 		}
 	}
 
@@ -293,13 +319,11 @@ int CP25Gateway::run()
 	std::vector<unsigned int> staticIds = m_conf.getNetworkStatic();
 
 	for (const auto& it : staticIds) {
-		CP25Reflector* reflector = m_reflectors->find(it);
-		if (reflector != nullptr) {
-			m_staticTGs.push_back(*reflector);
+		CP25Reflector reflector;
+		if (m_reflectors->find(it, reflector)) {
+			m_staticTGs.push_back(reflector);
 
-			m_remoteNetwork->poll(*reflector);
-			m_remoteNetwork->poll(*reflector);
-			m_remoteNetwork->poll(*reflector);
+			m_remoteNetwork->poll(reflector, 3U);
 
 			LogMessage("Statically linked to reflector %u", it);
 			writeJSONLinking("startup", it);
@@ -308,86 +332,37 @@ int CP25Gateway::run()
 		}
 	}
 
-	while (!m_killed) {
-		unsigned char buffer[200U];
-		sockaddr_storage addr;
-		unsigned int addrLen;
+	// Only built once the list is complete, the index points into it
+	m_sources.clear();
+	for (const auto& it : m_staticTGs)
+		m_sources.add(it);
+
+	// The static talk groups are announced most often, so render them once up front
+	if (m_voice != nullptr) {
+		for (const auto& it : m_staticTGs)
+			m_voice->prerender(it.m_id);
+	}
+
+	CUDPDatagram datagrams[UDP_BATCH_LENGTH];
 
+	while (!m_killed) {
 		// From the reflector to the MMDVM
-		unsigned int len = m_remoteNetwork->read(buffer, 200U, addr, addrLen);
+		unsigned int count = m_remoteNetwork->read(datagrams, UDP_BATCH_LENGTH);
 		// Read all queued packets so static talkgroup poll acks do not 
 		// cause a problem.
-		while (len > 0U) {
-			// If we're linked and it's from the right place, send it on
-			if (m_currentTG.isUsed() && CP25Network::match(addr, m_currentTG)) {
-				// Don't pass reflector control data through to the MMDVM
-				if ((buffer[0U] != 0xF0U) && (buffer[0U] != 0xF1U)) {
-					// Rewrite the LCF and the destination TG
-					if (buffer[0U] == 0x64U) {
-						buffer[1U] = 0x00U;			// LCF is for TGs
-					} else if (buffer[0U] == 0x65U) {
-						buffer[1U] = (m_currentTG.m_id >> 16) & 0xFFU;
-						buffer[2U] = (m_currentTG.m_id >> 8)  & 0xFFU;
-						buffer[3U] = (m_currentTG.m_id >> 0)  & 0xFFU;
-					}
-
-					if (!isVoiceBusy())
-						localNetwork.write(buffer, len);
-
-					m_hangTimer.start();
-				}
-			} else if (m_currentTG.isEmpty()) {
-				bool poll = false;
-				CP25Reflector receivedTG;
-				unsigned char pollReply[11U] = { 0xF0U };
-
-				std::string callsign = m_conf.getCallsign();
-				callsign.resize(10U, ' ');
-
-				// Build poll reply data
-				for (unsigned int i = 0U; i < 10U; i++)
-					pollReply[i + 1U] = callsign.at(i);
-
-				// Don't pass reflector control data through to the MMDVM
-				unsigned int pollLen = 11U;
-				if (len < pollLen)
-					pollLen = len;
-
-				poll = (::memcmp(buffer, pollReply, pollLen) == 0);
-
-				// Find the static TG that this audio data belongs to
-				for (const auto& it : m_staticTGs) {
-					if (CP25Network::match(addr, it)) {
-						receivedTG = it;
-						break;
-					}
-				}
-				// Reference for control byte buffer[0u]
-				// https://github.com/Wodie/p25link/blob/master/MMDVM.pm
-				if ((buffer[0U] == 0xF0U) && poll) {
-					// Poll response message
-					// LogMessage("Received network poll response for talkgroup %u ", receivedTG.m_id);
-				} else if (buffer[0U] == 0xF1U) {
-					// Server talkgroup disconnect
-					// LogMessage("Disconnect talkgroup for talkgroup %u ", receivedTG.m_id);
-				} else {
-					if (receivedTG.isUsed()) {
-						// Changed talkgroup.  Let the modem know.
-						// It may be told it by the content of the message.
-						// Just in case send it anyway!
-						unsigned char talkgroupBuff[4U];
-						talkgroupBuff[0U] = 0x65U;
-						talkgroupBuff[1U] = (receivedTG.m_id >> 16) & 0xFFU;
-						talkgroupBuff[2U] = (receivedTG.m_id >> 8)  & 0xFFU;
-						talkgroupBuff[3U] = (receivedTG.m_id >> 0)  & 0xFFU;
-
-						localNetwork.write(talkgroupBuff, 4U);
-					}
-
-					m_currentTG = receivedTG;
-					if (receivedTG.isUsed()) {
-						m_currentIsStatic = true;
-
+		while (count > 0U) {
+			for (unsigned int n = 0U; n < count; n++) {
+				unsigned char* buffer = datagrams[n].m_data;
+				unsigned int len = datagrams[n].m_length;
+				const sockaddr_storage& addr = datagrams[n].m_addr;
+
+				bool fromCurrent = false;
+				const CP25Reflector* fromStatic = m_sources.find(addr, fromCurrent);
+
+				// If we're linked and it's from the right place, send it on
+				if (m_currentTG.isUsed() && fromCurrent) {
+					// Don't pass reflector control data through to the MMDVM
+					if ((buffer[0U] != 0xF0U) && (buffer[0U] != 0xF1U)) {
 						// Rewrite the LCF and the destination TG
 						if (buffer[0U] == 0x64U) {
 							buffer[1U] = 0x00U;			// LCF is for TGs
@@ -397,132 +372,202 @@ int CP25Gateway::run()
 							buffer[3U] = (m_currentTG.m_id >> 0)  & 0xFFU;
 						}
 
-						if (!poll) {
-							if (!isVoiceBusy())
-								localNetwork.write(buffer, len);
-						}
-
-						LogMessage("Switched to reflector %u due to network activity", m_currentTG.m_id);
-						writeJSONLinking("network", m_currentTG.m_id);
+						if (!isVoiceBusy())
+							localNetwork.write(buffer, len);
 
-						m_hangTimer.setTimeout(netHangTime);
 						m_hangTimer.start();
 					}
+				} else if (m_currentTG.isEmpty()) {
+					bool poll = false;
+					CP25Reflector receivedTG;
+					unsigned char pollReply[11U] = { 0xF0U };
+
+					std::string callsign = m_conf.getCallsign();
+					callsign.resize(10U, ' ');
+
+					// Build poll reply data
+					for (unsigned int i = 0U; i < 10U; i++)
+						pollReply[i + 1U] = callsign.at(i);
+
+					// Don't pass reflector control data through to the MMDVM
+					unsigned int pollLen = 11U;
+					if (len < pollLen)
+						pollLen = len;
+
+					poll = (::memcmp(buffer, pollReply, pollLen) == 0);
+
+					// Find the static TG that this audio data belongs to
+					if (fromStatic != nullptr)
+						receivedTG = *fromStatic;
+					// Reference for control byte buffer[0u]
+					// https://github.com/Wodie/p25link/blob/master/MMDVM.pm
+					if ((buffer[0U] == 0xF0U) && poll) {
+						// Poll response message
+						// LogMessage("Received network poll response for talkgroup %u ", receivedTG.m_id);
+					} else if (buffer[0U] == 0xF1U) {
+						// Server talkgroup disconnect
+						// LogMessage("Disconnect talkgroup for talkgroup %u ", receivedTG.m_id);
+					} else {
+						if (receivedTG.isUsed()) {
+							// Changed talkgroup.  Let the modem know.
+							// It may be told it by the content of the message.
+							// Just in case send it anyway!
+							unsigned char talkgroupBuff[4U];
+							talkgroupBuff[0U] = 0x65U;
+							talkgroupBuff[1U] = (receivedTG.m_id >> 16) & 0xFFU;
+							talkgroupBuff[2U] = (receivedTG.m_id >> 8)  & 0xFFU;
+							talkgroupBuff[3U] = (receivedTG.m_id >> 0)  & 0xFFU;
+
+							localNetwork.write(talkgroupBuff, 4U);
+						}
+
+						m_currentTG = receivedTG;
+						m_sources.setCurrent(m_currentTG);
+						if (receivedTG.isUsed()) {
+							m_currentIsStatic = true;
+
+							// Rewrite the LCF and the destination TG
+							if (buffer[0U] == 0x64U) {
+								buffer[1U] = 0x00U;			// LCF is for TGs
+							} else if (buffer[0U] == 0x65U) {
+								buffer[1U] = (m_currentTG.m_id >> 16) & 0xFFU;
+								buffer[2U] = (m_currentTG.m_id >> 8)  & 0xFFU;
+								buffer[3U] = (m_currentTG.m_id >> 0)  & 0xFFU;
+							}
+
+							if (!poll) {
+								if (!isVoiceBusy())
+									localNetwork.write(buffer, len);
+							}
+
+							LogMessage("Switched to reflector %u due to network activity", m_currentTG.m_id);
+							writeJSONLinking("network", m_currentTG.m_id);
+
+							m_hangTimer.setTimeout(netHangTime);
+							m_hangTimer.start();
+						}
+					}
 				}
 			}
 
-			len = m_remoteNetwork->read(buffer, 200U, addr, addrLen);
+			count = m_remoteNetwork->read(datagrams, UDP_BATCH_LENGTH);
 		}
 
 		// From the MMDVM to the reflector or control data
-		len = localNetwork.read(buffer, 200U);
-		while (len > 0U) {
-			if (buffer[0U] == 0x65U) {
-				dstTG  = (buffer[1U] << 16) & 0xFF0000U;
-				dstTG |= (buffer[2U] << 8)  & 0x00FF00U;
-				dstTG |= (buffer[3U] << 0)  & 0x0000FFU;
-				if (dstTG != m_currentTG.m_id) {
-					if (m_currentTG.isUsed()) {
-						std::string callsign = lookup->find(srcId);
-						LogMessage("Unlinking from reflector %u by %s", m_currentTG.m_id, callsign.c_str());
-						writeJSONUnlinked("user");
-
-						if (!m_currentIsStatic) {
-							m_remoteNetwork->unlink(m_currentTG);
-							m_remoteNetwork->unlink(m_currentTG);
-							m_remoteNetwork->unlink(m_currentTG);
+		count = localNetwork.read(datagrams, UDP_BATCH_LENGTH);
+		while (count > 0U) {
+			for (unsigned int n = 0U; n < count; n++) {
+				unsigned char* buffer = datagrams[n].m_data;
+				unsigned int len = datagrams[n].m_length;
+
+				if (buffer[0U] == 0x65U) {
+					dstTG  = (buffer[1U] << 16) & 0xFF0000U;
+					dstTG |= (buffer[2U] << 8)  & 0x00FF00U;
+					dstTG |= (buffer[3U] << 0)  & 0x0000FFU;
+					if (dstTG != m_currentTG.m_id) {
+						if (m_currentTG.isUsed()) {
+							std::string callsign = m_lookup->find(srcId);
+							LogMessage("Unlinking from reflector %u by %s", m_currentTG.m_id, callsign.c_str());
+							writeJSONUnlinked("user");
+
+							if (!m_currentIsStatic) {
+								m_remoteNetwork->unlink(m_currentTG, 3U);
+							}
+
+							m_hangTimer.stop();
 						}
 
-						m_hangTimer.stop();
-					}
-
-					CP25Reflector found;
-					for (const auto& it : m_staticTGs) {
-						if (dstTG == it.m_id) {
-							found = it;
-							break;
+						CP25Reflector found;
+						for (const auto& it : m_staticTGs) {
+							if (dstTG == it.m_id) {
+								found = it;
+								break;
+							}
 						}
-					}
 
-					if (found.isEmpty()) {
-						CP25Reflector* refl = m_reflectors->find(dstTG);
-						if (refl != nullptr) {
-							m_currentTG       = *refl;
+						if (found.isEmpty()) {
+							if (!m_reflectors->find(dstTG, m_currentTG))
+								m_currentTG.reset();
 							m_currentIsStatic = false;
 						} else {
-							m_currentTG.reset();
-							m_currentIsStatic = false;
+							m_currentTG       = found;
+							m_currentIsStatic = true;
 						}
-					} else {
-						m_currentTG       = found;
-						m_currentIsStatic = true;
-					}
 
-					// Link to the new reflector
-					if (m_currentTG.isUsed()) {
-						std::string callsign = lookup->find(srcId);
-						LogMessage("Switched to reflector %u due to RF activity from %s", m_currentTG.m_id, callsign.c_str());
-						writeJSONLinking("user", m_currentTG.m_id);
+						m_sources.setCurrent(m_currentTG);
+
+						// Link to the new reflector
+						if (m_currentTG.isUsed()) {
+							std::string callsign = m_lookup->find(srcId);
+							LogMessage("Switched to reflector %u due to RF activity from %s", m_currentTG.m_id, callsign.c_str());
+							writeJSONLinking("user", m_currentTG.m_id);
+
+							if (!m_currentIsStatic) {
+								m_remoteNetwork->poll(m_currentTG, 3U);
+							}
 
-						if (!m_currentIsStatic) {
-							m_remoteNetwork->poll(m_currentTG);
-							m_remoteNetwork->poll(m_currentTG);
-							m_remoteNetwork->poll(m_currentTG);
+							m_hangTimer.setTimeout(m_rfHangTime);
+							m_hangTimer.start();
+						} else {
+							m_hangTimer.stop();
 						}
 
-						m_hangTimer.setTimeout(m_rfHangTime);
-						m_hangTimer.start();
-					} else {
-						m_hangTimer.stop();
+						if (m_voice != nullptr) {
+							if (m_currentTG.isEmpty())
+								m_voice->unlinked();
+							else
+								m_voice->linkedTo(dstTG);
+						}
 					}
+				} else if (buffer[0U] == 0x66U) {
+					srcId  = (buffer[1U] << 16) & 0xFF0000U;
+					srcId |= (buffer[2U] << 8)  & 0x00FF00U;
+					srcId |= (buffer[3U] << 0)  & 0x0000FFU;
+				}
 
-					if (m_voice != nullptr) {
-						if (m_currentTG.isEmpty())
-							m_voice->unlinked();
-						else
-							m_voice->linkedTo(dstTG);
-					}
+				if (buffer[0U] == 0x80U) {
+					if (m_voice != nullptr)
+						m_voice->eof();
 				}
-			} else if (buffer[0U] == 0x66U) {
-				srcId  = (buffer[1U] << 16) & 0xFF0000U;
-				srcId |= (buffer[2U] << 8)  & 0x00FF00U;
-				srcId |= (buffer[3U] << 0)  & 0x0000FFU;
-			}
 
-			if (buffer[0U] == 0x80U) {
-				if (m_voice != nullptr)
-					m_voice->eof();
-			}
+				// If we're linked and we have a network, send it on
+				if (m_currentTG.isUsed()) {
+					// Rewrite the LCF and the destination TG
+					if (buffer[0U] == 0x64U) {
+						buffer[1U] = 0x00U;			// LCF is for TGs
+					} else if (buffer[0U] == 0x65U) {
+						buffer[1U] = (m_currentTG.m_id >> 16) & 0xFFU;
+						buffer[2U] = (m_currentTG.m_id >> 8)  & 0xFFU;
+						buffer[3U] = (m_currentTG.m_id >> 0)  & 0xFFU;
+					}
 
-			// If we're linked and we have a network, send it on
-			if (m_currentTG.isUsed()) {
-				// Rewrite the LCF and the destination TG
-				if (buffer[0U] == 0x64U) {
-					buffer[1U] = 0x00U;			// LCF is for TGs
-				} else if (buffer[0U] == 0x65U) {
-					buffer[1U] = (m_currentTG.m_id >> 16) & 0xFFU;
-					buffer[2U] = (m_currentTG.m_id >> 8)  & 0xFFU;
-					buffer[3U] = (m_currentTG.m_id >> 0)  & 0xFFU;
+					m_remoteNetwork->write(buffer, len, m_currentTG);
+					m_hangTimer.start();
 				}
-
-				m_remoteNetwork->write(buffer, len, m_currentTG);
-				m_hangTimer.start();
 			}
 
-			len = localNetwork.read(buffer, 200U);
+			count = localNetwork.read(datagrams, UDP_BATCH_LENGTH);
 		}
 
+		// Remote commands arrive on the MQTT thread but are acted on here
+		std::vector<std::string> commands;
+		m_mutex.lock();
+		commands.swap(m_commands);
+		m_mutex.unlock();
+
+		for (const auto& command : commands)
+			writeCommand(command);
+
 		if (m_voice != nullptr) {
-			unsigned int length = m_voice->read(buffer);
-			if (length > 0U)
-				localNetwork.write(buffer, length);
+			const unsigned char* data = nullptr;
+			unsigned int length;
+			while ((length = m_voice->read(data)) > 0U)
+				localNetwork.write(data, length);
 		}
 
 		unsigned int ms = stopWatch.elapsed();
 		stopWatch.start();
 
-		m_reflectors->clock(ms);
-
 		if (m_voice != nullptr)
 			m_voice->clock(ms);
 
@@ -533,9 +578,7 @@ int CP25Gateway::run()
 				writeJSONUnlinked("timer");
 
 				if (!m_currentIsStatic) {
-					m_remoteNetwork->unlink(m_currentTG);
-					m_remoteNetwork->unlink(m_currentTG);
-					m_remoteNetwork->unlink(m_currentTG);
+					m_remoteNetwork->unlink(m_currentTG, 3U);
 				}
 
 				if (m_voice != nullptr)
@@ -543,6 +586,7 @@ int CP25Gateway::run()
 			}
 			
 			m_currentTG.reset();
+			m_sources.setCurrent(m_currentTG);
 			m_currentIsStatic = false;
 
 			// Let modem know disconnected
@@ -560,8 +604,7 @@ int CP25Gateway::run()
 		pollTimer.clock(ms);
 		if (pollTimer.isRunning() && pollTimer.hasExpired()) {
 			// Poll the static TGs
-			for (const auto& it : m_staticTGs)
-				m_remoteNetwork->poll(it);
+			m_remoteNetwork->poll(m_staticTGs);
 
 			// Poll the dynamic TG
 			if (!m_currentIsStatic && m_currentTG.isUsed())
@@ -570,10 +613,18 @@ int CP25Gateway::run()
 			pollTimer.start();
 		}
 
-		if (ms < 5U)
-			CThread::sleep(5U);
+		// Sleep until there is network data or the next timer is due
+		unsigned int timeout = std::min(pollTimer.getRemainingMS(), m_hangTimer.getRemainingMS());
+		timeout = std::min(timeout, localNetwork.getRemainingMS());
+		if (m_voice != nullptr)
+			timeout = std::min(timeout, m_voice->getRemainingMS());
+
+		// Voice frames are paced to the nanosecond, not to the next whole millisecond
+		m_poller.wait(timeout, (m_voice != nullptr) ? m_voice->getDeadline() : 0U);
 	}
 
+	m_poller.close();
+
 	delete m_voice;
 
 	localNetwork.close();
@@ -581,7 +632,12 @@ int CP25Gateway::run()
 	m_remoteNetwork->close();
 	delete m_remoteNetwork;
 
-	lookup->stop();
+	m_lookup->stop();
+	m_lookup = nullptr;
+
+	m_reflectors->stop();
+	delete m_reflectors;
+	m_reflectors = nullptr;
 
 	return 0;
 }
@@ -599,9 +655,7 @@ void CP25Gateway::writeCommand(const std::string& command)
 				writeJSONUnlinked("remote");
 
 				if (!m_currentIsStatic) {
-					m_remoteNetwork->unlink(m_currentTG);
-					m_remoteNetwork->unlink(m_currentTG);
-					m_remoteNetwork->unlink(m_currentTG);
+					m_remoteNetwork->unlink(m_currentTG, 3U);
 				}
 
 				m_hangTimer.stop();
@@ -616,28 +670,23 @@ void CP25Gateway::writeCommand(const std::string& command)
 			}
 
 			if (found.isEmpty()) {
-				CP25Reflector* refl = m_reflectors->find(tg);
-				if (refl != nullptr) {
-					m_currentTG = *refl;
-					m_currentIsStatic = false;
-				} else {
+				if (!m_reflectors->find(tg, m_currentTG))
 					m_currentTG.reset();
-					m_currentIsStatic = false;
-				}
+				m_currentIsStatic = false;
 			} else {
 				m_currentTG = found;
 				m_currentIsStatic = true;
 			}
 
+			m_sources.setCurrent(m_currentTG);
+
 			// Link to the new reflector
 			if (m_currentTG.isUsed()) {
 				LogMessage("Switched to reflector %u by remote command", m_currentTG.m_id);
 				writeJSONLinking("remote", m_currentTG.m_id);
 
 				if (!m_currentIsStatic) {
-					m_remoteNetwork->poll(m_currentTG);
-					m_remoteNetwork->poll(m_currentTG);
-					m_remoteNetwork->poll(m_currentTG);
+					m_remoteNetwork->poll(m_currentTG, 3U);
 				}
 
 				m_hangTimer.setTimeout(m_rfHangTime);
@@ -672,6 +721,36 @@ void CP25Gateway::writeCommand(const std::string& command)
 		}
 
 		m_mqtt->publish("response", host);
+	} else if (command.substr(0, 6) == "lookup") {
+		std::string key = command.length() > 7 ? command.substr(7) : std::string();
+
+		std::vector<unsigned int> ids;
+		if (!key.empty() && (key.find_first_not_of("0123456789") == std::string::npos))
+			ids.push_back((unsigned int)::strtoul(key.c_str(), nullptr, 10));
+		else if (!key.empty())
+			ids = m_lookup->findIds(key);
+
+		// Each match is returned as id callsign "name", separated by commas, with
+		// any quote or backslash in the name escaped by a backslash
+		std::string reply;
+		for (const auto& id : ids) {
+			std::string callsign, name;
+			if (!m_lookup->find(id, callsign, name))
+				continue;
+
+			if (!reply.empty())
+				reply += ",";
+
+			reply += std::to_string(id) + " " + callsign + " \"";
+			for (const auto& c : name) {
+				if ((c == '"') || (c == '\\'))
+					reply += '\\';
+				reply += c;
+			}
+			reply += "\"";
+		}
+
+		m_mqtt->publish("response", reply.empty() ? std::string("p25:\"NONE\"") : "p25:" + reply);
 	} else {
 		CUtils::dump("Invalid remote command received", (unsigned char*)command.c_str(), (unsigned int)command.length());
 	}
@@ -726,7 +805,12 @@ void CP25Gateway::onCommand(const unsigned char* command, unsigned int length)
 	assert(gateway != nullptr);
 	assert(command != nullptr);
 
-	gateway->writeCommand(std::string((char*)command, length));
+	gateway->m_mutex.lock();
+	gateway->m_commands.push_back(std::string((char*)command, length));
+	gateway->m_mutex.unlock();
+
+	// The main loop may be asleep until its next timer is due
+	gateway->m_poller.wake();
 }
 
 bool CP25Gateway::isVoiceBusy() const
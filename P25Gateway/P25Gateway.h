@@ -1,5 +1,5 @@
 /*
-*   Copyright (C) 2016,2024 by Jonathan Naylor G4KLX
+*   Copyright (C) 2016,2024,2026 by Jonathan Naylor G4KLX
 *
 *   This program is free software; you can redistribute it and/or modify
 *   it under the terms of the GNU General Public License as published by
@@ -20,7 +20,11 @@
 #define	P25Gateway_H
 
 #include "P25Network.h"
+#include "ReflectorIndex.h"
 #include "Reflectors.h"
+#include "DMRLookup.h"
+#include "Poller.h"
+#include "Mutex.h"
 #include "Voice.h"
 #include "Timer.h"
 #include "Conf.h"
@@ -62,10 +66,15 @@ private:
 	CP25Network*  m_remoteNetwork;
 	std::vector<CP25Reflector> m_staticTGs;
 	CP25Reflector m_currentTG;
+	CReflectorIndex m_sources;
 	bool          m_currentIsStatic;
 	CTimer        m_hangTimer;
 	unsigned int  m_rfHangTime;
 	CReflectors*  m_reflectors;	
+	CDMRLookup*   m_lookup;
+	CPoller       m_poller;
+	CMutex        m_mutex;
+	std::vector<std::string> m_commands;
 
 	bool isVoiceBusy() const;
 
@@ -1,5 +1,5 @@
 /*
- *   Copyright (C) 2009-2014,2016,2020,2024,2025 by Jonathan Naylor G4KLX
+ *   Copyright (C) 2009-2014,2016,2020,2024,2025,2026 by Jonathan Naylor G4KLX
  *
  *   This program is free software; you can redistribute it and/or modify
  *   it under the terms of the GNU General Public License as published by
@@ -24,15 +24,18 @@
 #include <cassert>
 #include <cstring>
 
-CP25Network::CP25Network(unsigned short port, const std::string& callsign, bool debug) :
+CP25Network::CP25Network(unsigned short port, const std::string& callsign, bool dualStack, bool debug) :
 m_callsign(callsign),
 m_socket4(nullptr),
 m_socket6(nullptr),
+m_dualStack(dualStack),
 m_debug(debug)
 {
 	assert(port > 0U);
 
-	m_socket4 = new CUDPSocket(port);
+	// In dual stack mode a single IPv6 socket also carries the IPv4 traffic
+	if (!dualStack)
+		m_socket4 = new CUDPSocket(port);
 	m_socket6 = new CUDPSocket(port);
 
 	m_callsign.resize(10U, ' ');
@@ -48,6 +51,22 @@ bool CP25Network::open()
 {
 	LogInfo("Opening P25 network connection");
 
+	if (m_dualStack) {
+		sockaddr_storage addr6;
+		addr6.ss_family = AF_INET6;
+
+		bool ret6 = m_socket6->open(addr6, true);
+		if (!ret6) {
+			delete m_socket6;
+			m_socket6 = nullptr;
+
+			LogError("Unable to open a dual stack IPv6 socket");
+			return false;
+		}
+
+		return true;
+	}
+
 	sockaddr_storage addr4;
 	addr4.ss_family = AF_INET;
 
@@ -84,6 +103,11 @@ bool CP25Network::write(const unsigned char* data, unsigned int length, const CP
 
 	if (address.hasIPv6() && hasIPv6()) {
 		return m_socket6->write(data, length , address.IPv6.m_addr, address.IPv6.m_addrLen);
+	} else if (address.hasIPv4() && m_dualStack && hasIPv4()) {
+		sockaddr_storage addr;
+		unsigned int addrLen;
+		CUDPSocket::mapIPv4(address.IPv4.m_addr, addr, addrLen);
+		return m_socket6->write(data, length, addr, addrLen);
 	} else if (address.hasIPv4() && hasIPv4()) {
 		return m_socket4->write(data, length, address.IPv4.m_addr, address.IPv4.m_addrLen);
 	} else {
@@ -92,8 +116,10 @@ bool CP25Network::write(const unsigned char* data, unsigned int length, const CP
 	}
 }
 
-bool CP25Network::poll(const CP25Reflector& address)
+bool CP25Network::poll(const CP25Reflector& address, unsigned int count)
 {
+	assert(count > 0U);
+
 	unsigned char data[15U];
 
 	data[0U] = 0xF0U;
@@ -104,18 +130,31 @@ bool CP25Network::poll(const CP25Reflector& address)
 	if (m_debug)
 		CUtils::dump(1U, "P25 Network Poll Sent", data, 11U);
 
-	if (address.hasIPv6() && hasIPv6()) {
-		return m_socket6->write(data, 11U, address.IPv6.m_addr, address.IPv6.m_addrLen);
-	} else if (address.hasIPv4() && hasIPv4()) {
-		return m_socket4->write(data, 11U, address.IPv4.m_addr, address.IPv4.m_addrLen);
-	} else {
-		LogError("No suitable IP address to poll TG%u", address.m_id);
-		return false;
-	}
+	return write(data, 11U, &address, 1U, count);
 }
 
-bool CP25Network::unlink(const CP25Reflector& address)
+bool CP25Network::poll(const std::vector<CP25Reflector>& addresses)
 {
+	if (addresses.empty())
+		return true;
+
+	unsigned char data[15U];
+
+	data[0U] = 0xF0U;
+
+	for (unsigned int i = 0U; i < 10U; i++)
+		data[i + 1U] = m_callsign.at(i);
+
+	if (m_debug)
+		CUtils::dump(1U, "P25 Network Poll Sent", data, 11U);
+
+	return write(data, 11U, addresses.data(), (unsigned int)addresses.size(), 1U);
+}
+
+bool CP25Network::unlink(const CP25Reflector& address, unsigned int count)
+{
+	assert(count > 0U);
+
 	unsigned char data[15U];
 
 	data[0U] = 0xF1U;
@@ -126,51 +165,136 @@ bool CP25Network::unlink(const CP25Reflector& address)
 	if (m_debug)
 		CUtils::dump(1U, "P25 Network Unlink Sent", data, 11U);
 
-	if (address.hasIPv6() && hasIPv6()) {
-		return m_socket6->write(data, 11U, address.IPv6.m_addr, address.IPv6.m_addrLen);
-	} else if (address.hasIPv4() && hasIPv4()) {
-		return m_socket4->write(data, 11U, address.IPv4.m_addr, address.IPv4.m_addrLen);
-	} else {
-		LogError("No suitable IP address to unlink from TG%u", address.m_id);
-		return false;
-	}
+	return write(data, 11U, &address, 1U, count);
 }
 
-unsigned int CP25Network::read(unsigned char* data, unsigned int length, sockaddr_storage& addr, unsigned int& addrLen)
+bool CP25Network::write(const unsigned char* data, unsigned int length, const CP25Reflector* addresses, unsigned int n, unsigned int count)
 {
 	assert(data != nullptr);
-	assert(length > 0U);
-
-	if (hasIPv4()) {
-		int len = m_socket4->read(data, length, addr, addrLen);
-		if (len > 0) {
-			if (m_debug)
-				CUtils::dump(1U, "P25 Network Data Received", data, len);
-			return len;
+	assert(length <= UDP_DATAGRAM_LENGTH);
+	assert(addresses != nullptr);
+
+	// Queue the datagrams per socket and send each queue with as few system calls as possible
+	CUDPDatagram datagrams4[UDP_BATCH_LENGTH];
+	CUDPDatagram datagrams6[UDP_BATCH_LENGTH];
+	unsigned int count4 = 0U;
+	unsigned int count6 = 0U;
+
+	bool ret = true;
+
+	for (unsigned int i = 0U; i < n; i++) {
+		const CP25Reflector& address = addresses[i];
+
+		for (unsigned int j = 0U; j < count; j++) {
+			if (address.hasIPv6() && hasIPv6()) {
+				CUDPDatagram& datagram = datagrams6[count6++];
+				::memcpy(datagram.m_data, data, length);
+				datagram.m_length  = length;
+				datagram.m_addr    = address.IPv6.m_addr;
+				datagram.m_addrLen = address.IPv6.m_addrLen;
+
+				if (count6 == UDP_BATCH_LENGTH)
+					ret = flush(m_socket6, datagrams6, count6) && ret;
+			} else if (address.hasIPv4() && m_dualStack && hasIPv4()) {
+				CUDPDatagram& datagram = datagrams6[count6++];
+				::memcpy(datagram.m_data, data, length);
+				datagram.m_length = length;
+				CUDPSocket::mapIPv4(address.IPv4.m_addr, datagram.m_addr, datagram.m_addrLen);
+
+				if (count6 == UDP_BATCH_LENGTH)
+					ret = flush(m_socket6, datagrams6, count6) && ret;
+			} else if (address.hasIPv4() && hasIPv4()) {
+				CUDPDatagram& datagram = datagrams4[count4++];
+				::memcpy(datagram.m_data, data, length);
+				datagram.m_length  = length;
+				datagram.m_addr    = address.IPv4.m_addr;
+				datagram.m_addrLen = address.IPv4.m_addrLen;
+
+				if (count4 == UDP_BATCH_LENGTH)
+					ret = flush(m_socket4, datagrams4, count4) && ret;
+			} else {
+				LogError("No suitable IP address to write to TG%u", address.m_id);
+				ret = false;
+				break;
+			}
 		}
 	}
 
-	if (hasIPv6()) {
-		int len = m_socket6->read(data, length, addr, addrLen);
-		if (len > 0) {
-			if (m_debug)
-				CUtils::dump(1U, "P25 Network Data Received", data, len);
-			return len;
-		}
+	ret = flush(m_socket6, datagrams6, count6) && ret;
+	ret = flush(m_socket4, datagrams4, count4) && ret;
+
+	return ret;
+}
+
+bool CP25Network::flush(CUDPSocket* socket, CUDPDatagram* datagrams, unsigned int& count)
+{
+	if (count == 0U)
+		return true;
+
+	assert(socket != nullptr);
+
+	int ret = socket->write(datagrams, count);
+
+	bool ok = (ret == int(count));
+
+	count = 0U;
+
+	return ok;
+}
+
+unsigned int CP25Network::read(CUDPDatagram* datagrams, unsigned int count)
+{
+	assert(datagrams != nullptr);
+	assert(count > 0U);
+
+	unsigned int n = 0U;
+
+	if (m_socket4 != nullptr) {
+		int ret = m_socket4->read(datagrams, count);
+		if (ret > 0)
+			n += ret;
+	}
+
+	if ((m_socket6 != nullptr) && (n < count)) {
+		int ret = m_socket6->read(datagrams + n, count - n);
+		if (ret > 0)
+			n += ret;
 	}
 
-	return 0U;
+	if (m_debug) {
+		for (unsigned int i = 0U; i < n; i++)
+			CUtils::dump(1U, "P25 Network Data Received", datagrams[i].m_data, datagrams[i].m_length);
+	}
+
+	return n;
+}
+
+bool CP25Network::registerSockets(CPoller& poller)
+{
+	if (m_socket4 != nullptr) {
+		bool ret = poller.add(*m_socket4);
+		if (!ret)
+			return false;
+	}
+
+	if (m_socket6 != nullptr) {
+		bool ret = poller.add(*m_socket6);
+		if (!ret)
+			return false;
+	}
+
+	return true;
 }
 
 void CP25Network::close()
 {
-	if (hasIPv4()) {
+	if (m_socket4 != nullptr) {
 		m_socket4->close();
 		delete m_socket4;
 		m_socket4 = nullptr;
 	}
 
-	if (hasIPv6()) {
+	if (m_socket6 != nullptr) {
 		m_socket6->close();
 		delete m_socket6;
 		m_socket6 = nullptr;
@@ -181,6 +305,9 @@ void CP25Network::close()
 
 bool CP25Network::hasIPv4() const
 {
+	if (m_dualStack)
+		return m_socket6 != nullptr;
+
 	return m_socket4 != nullptr;
 }
 
@@ -188,22 +315,3 @@ bool CP25Network::hasIPv6() const
 {
 	return m_socket6 != nullptr;
 }
-
-bool CP25Network::match(const sockaddr_storage& address, const CP25Reflector& reflector)
-{
-	switch (address.ss_family) {
-		case AF_INET:
-			if (!reflector.hasIPv4())
-				return false;
-			return CUDPSocket::match(address, reflector.IPv4.m_addr);
-
-		case AF_INET6:
-			if (!reflector.hasIPv6())
-				return false;
-			return CUDPSocket::match(address, reflector.IPv6.m_addr);
-
-		default:
-			LogError("Trying to match an unknown protocol family - %d", address.ss_family);
-			return false;
-	}
-}
@@ -1,5 +1,5 @@
 /*
- *   Copyright (C) 2009-2014,2016,2020,2024,2025 by Jonathan Naylor G4KLX
+ *   Copyright (C) 2009-2014,2016,2020,2024,2025,2026 by Jonathan Naylor G4KLX
  *
  *   This program is free software; you can redistribute it and/or modify
  *   it under the terms of the GNU General Public License as published by
@@ -21,37 +21,44 @@
 
 #include "Reflectors.h"
 #include "UDPSocket.h"
+#include "Poller.h"
 
 #include <cstdint>
 #include <string>
+#include <vector>
 
 class CP25Network {
 public:
-	CP25Network(unsigned short port, const std::string& callsign, bool debug);
+	CP25Network(unsigned short port, const std::string& callsign, bool dualStack, bool debug);
 	~CP25Network();
 
 	bool open();
 
 	bool write(const unsigned char* data, unsigned int length, const CP25Reflector& address);
 
-	unsigned int read(unsigned char* data, unsigned int length, sockaddr_storage& addr, unsigned int& addrLen);
+	unsigned int read(CUDPDatagram* datagrams, unsigned int count);
 
-	bool poll(const CP25Reflector& address);
+	bool poll(const CP25Reflector& address, unsigned int count = 1U);
+	bool poll(const std::vector<CP25Reflector>& addresses);
 
-	bool unlink(const CP25Reflector& address);
+	bool unlink(const CP25Reflector& address, unsigned int count = 1U);
+
+	bool registerSockets(CPoller& poller);
 
 	void close();
 
 	bool hasIPv4() const;
 	bool hasIPv6() const;
 
-	static bool match(const sockaddr_storage& address, const CP25Reflector& reflector);
-
 private:
 	std::string m_callsign;
 	CUDPSocket* m_socket4;
 	CUDPSocket* m_socket6;
+	bool        m_dualStack;
 	bool        m_debug;
+
+	bool write(const unsigned char* data, unsigned int length, const CP25Reflector* addresses, unsigned int n, unsigned int count);
+	bool flush(CUDPSocket* socket, CUDPDatagram* datagrams, unsigned int& count);
 };
 
 #endif
@@ -0,0 +1,360 @@
+/*
+ *   Copyright (C) 2026 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "FrameClock.h"
+#include "Poller.h"
+#include "Log.h"
+
+#include <cassert>
+
+#if defined(_WIN32) || defined(_WIN64)
+
+// WSAPoll cannot wait for an event as well, so a wake is noticed within this time
+const unsigned int WAKE_INTERVAL = 10U;
+
+CPoller::CPoller() :
+m_sockets(),
+m_woken(false)
+{
+}
+
+CPoller::~CPoller()
+{
+}
+
+bool CPoller::open()
+{
+	return true;
+}
+
+bool CPoller::add(const CUDPSocket& socket)
+{
+	if (socket.getFd() == INVALID_SOCKET)
+		return false;
+
+	m_sockets.push_back(&socket);
+
+	return true;
+}
+
+int CPoller::wait(unsigned int ms)
+{
+	for (;;) {
+		if (m_woken.exchange(false))
+			return 0;
+
+		unsigned int slice = ((ms != NO_TIMEOUT) && (ms < WAKE_INTERVAL)) ? ms : WAKE_INTERVAL;
+
+		// The sockets are read each time, so one that has been re-opened is still waited on
+		std::vector<WSAPOLLFD> pfds;
+		for (const auto& it : m_sockets) {
+			SOCKET fd = it->getFd();
+			if (fd != INVALID_SOCKET) {
+				WSAPOLLFD pfd;
+				pfd.fd      = fd;
+				pfd.events  = POLLIN;
+				pfd.revents = 0;
+				pfds.push_back(pfd);
+			}
+		}
+
+		if (pfds.empty()) {
+			::Sleep(slice);
+		} else {
+			int ret = ::WSAPoll(pfds.data(), ULONG(pfds.size()), int(slice));
+			if (ret < 0) {
+				LogError("Error returned from WSAPoll, err: %lu", ::GetLastError());
+				return -1;
+			}
+
+			if (ret > 0)
+				return ret;
+		}
+
+		if (ms != NO_TIMEOUT) {
+			ms -= slice;
+			if (ms == 0U)
+				return 0;
+		}
+	}
+}
+
+int CPoller::wait(unsigned int ms, uint64_t deadline)
+{
+	if (deadline == 0U)
+		return wait(ms);
+
+	uint64_t now = CFrameClock::now();
+	if (deadline <= now)
+		return 0;
+
+	// Round up, waking early would only mean waiting again
+	uint64_t remaining = (deadline - now + 999999ULL) / 1000000ULL;
+	if ((ms != NO_TIMEOUT) && (ms <= remaining))
+		return wait(ms);
+
+	return wait((unsigned int)remaining);
+}
+
+void CPoller::wake()
+{
+	m_woken = true;
+}
+
+void CPoller::close()
+{
+	m_sockets.clear();
+}
+
+#else
+
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <sys/epoll.h>
+
+#include <cstdint>
+#include <cerrno>
+#include <cstring>
+
+CPoller::CPoller() :
+m_sockets(),
+m_generations(),
+m_epollFd(-1),
+m_timerFd(-1),
+m_wakeFd(-1)
+{
+}
+
+CPoller::~CPoller()
+{
+	close();
+}
+
+bool CPoller::open()
+{
+	assert(m_epollFd == -1);
+
+	m_epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+	if (m_epollFd == -1) {
+		LogError("Cannot create the epoll instance, err: %d", errno);
+		return false;
+	}
+
+	m_timerFd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (m_timerFd == -1) {
+		LogError("Cannot create the poll timer, err: %d", errno);
+		close();
+		return false;
+	}
+
+	struct epoll_event ev;
+	::memset(&ev, 0x00U, sizeof(struct epoll_event));
+	ev.events  = EPOLLIN;
+	ev.data.fd = m_timerFd;
+
+	if (::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_timerFd, &ev) == -1) {
+		LogError("Cannot add the poll timer to epoll, err: %d", errno);
+		close();
+		return false;
+	}
+
+	m_wakeFd = ::eventfd(0U, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (m_wakeFd == -1) {
+		LogError("Cannot create the poll wake event, err: %d", errno);
+		close();
+		return false;
+	}
+
+	ev.data.fd = m_wakeFd;
+
+	if (::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeFd, &ev) == -1) {
+		LogError("Cannot add the poll wake event to epoll, err: %d", errno);
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+bool CPoller::add(const CUDPSocket& socket)
+{
+	assert(m_epollFd != -1);
+
+	int fd = socket.getFd();
+	if (fd == -1)
+		return false;
+
+	struct epoll_event ev;
+	::memset(&ev, 0x00U, sizeof(struct epoll_event));
+	ev.events  = EPOLLIN;
+	ev.data.fd = fd;
+
+	if (::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+		LogError("Cannot add a socket to epoll, err: %d", errno);
+		return false;
+	}
+
+	m_sockets.push_back(&socket);
+	m_generations.push_back(socket.getGeneration());
+
+	return true;
+}
+
+bool CPoller::update()
+{
+	// A socket that has been re-opened after an error is usually given the same
+	// fd back, but closing the old one has already taken it out of the epoll set
+	for (unsigned int i = 0U; i < m_sockets.size(); i++) {
+		unsigned int generation = m_sockets[i]->getGeneration();
+		if (generation == m_generations[i])
+			continue;
+
+		m_generations[i] = generation;
+
+		int fd = m_sockets[i]->getFd();
+		if (fd == -1)
+			continue;
+
+		struct epoll_event ev;
+		::memset(&ev, 0x00U, sizeof(struct epoll_event));
+		ev.events  = EPOLLIN;
+		ev.data.fd = fd;
+
+		if ((::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &ev) == -1) && (errno != EEXIST)) {
+			LogError("Cannot add a re-opened socket to epoll, err: %d", errno);
+			return false;
+		}
+
+		LogMessage("Added a re-opened socket to epoll");
+	}
+
+	return true;
+}
+
+int CPoller::wait(unsigned int ms)
+{
+	assert(m_epollFd != -1);
+
+	if (ms == 0U)
+		return 0;
+
+	// An it_value of zero disarms the timer, so NO_TIMEOUT simply leaves it that way
+	struct itimerspec its;
+	::memset(&its, 0x00U, sizeof(struct itimerspec));
+	if (ms != NO_TIMEOUT) {
+		its.it_value.tv_sec  = ms / 1000U;
+		its.it_value.tv_nsec = (ms % 1000U) * 1000000L;
+	}
+
+	return poll(its, 0);
+}
+
+int CPoller::wait(unsigned int ms, uint64_t deadline)
+{
+	if (deadline == 0U)
+		return wait(ms);
+
+	uint64_t now = CFrameClock::now();
+	if (deadline <= now)
+		return 0;
+
+	if ((ms != NO_TIMEOUT) && ((now + uint64_t(ms) * 1000000ULL) <= deadline))
+		return wait(ms);
+
+	// The timer is set to the deadline itself, rather than to a whole number of milliseconds from now
+	struct itimerspec its;
+	::memset(&its, 0x00U, sizeof(struct itimerspec));
+	its.it_value.tv_sec  = time_t(deadline / 1000000000ULL);
+	its.it_value.tv_nsec = long(deadline % 1000000000ULL);
+
+	return poll(its, TFD_TIMER_ABSTIME);
+}
+
+int CPoller::poll(const struct itimerspec& its, int flags)
+{
+	assert(m_epollFd != -1);
+
+	if (!update())
+		return -1;
+
+	if (::timerfd_settime(m_timerFd, flags, &its, nullptr) == -1) {
+		LogError("Cannot set the poll timer, err: %d", errno);
+		return -1;
+	}
+
+	struct epoll_event events[10U];
+	int ret = ::epoll_wait(m_epollFd, events, 10, -1);
+	if (ret < 0) {
+		// A signal is not an error, the caller will check why it was woken
+		if (errno == EINTR)
+			return 0;
+
+		LogError("Error returned from epoll_wait, err: %d", errno);
+		return -1;
+	}
+
+	int count = 0;
+	for (int i = 0; i < ret; i++) {
+		if (events[i].data.fd == m_timerFd) {
+			uint64_t expirations;
+			ssize_t n = ::read(m_timerFd, &expirations, sizeof(uint64_t));
+			(void)n;
+		} else if (events[i].data.fd == m_wakeFd) {
+			uint64_t wakes;
+			ssize_t n = ::read(m_wakeFd, &wakes, sizeof(uint64_t));
+			(void)n;
+		} else {
+			count++;
+		}
+	}
+
+	return count;
+}
+
+void CPoller::wake()
+{
+	if (m_wakeFd == -1)
+		return;
+
+	uint64_t one = 1U;
+	ssize_t n = ::write(m_wakeFd, &one, sizeof(uint64_t));
+	(void)n;
+}
+
+void CPoller::close()
+{
+	m_sockets.clear();
+	m_generations.clear();
+
+	if (m_wakeFd != -1) {
+		::close(m_wakeFd);
+		m_wakeFd = -1;
+	}
+
+	if (m_timerFd != -1) {
+		::close(m_timerFd);
+		m_timerFd = -1;
+	}
+
+	if (m_epollFd != -1) {
+		::close(m_epollFd);
+		m_epollFd = -1;
+	}
+}
+
+#endif
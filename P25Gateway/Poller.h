@@ -0,0 +1,71 @@
+/*
+ *   Copyright (C) 2026 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef	Poller_H
+#define	Poller_H
+
+#include "UDPSocket.h"
+#include "Timer.h"
+
+#include <vector>
+
+#include <cstdint>
+#if defined(_WIN32) || defined(_WIN64)
+#include <atomic>
+#endif
+
+// Waits until one of the registered sockets is readable, the timeout expires
+// or another thread calls wake(). Uses epoll, a timerfd and an eventfd on
+// Linux, WSAPoll on Windows.
+class CPoller {
+public:
+	CPoller();
+	~CPoller();
+
+	bool open();
+
+	bool add(const CUDPSocket& socket);
+
+	// A timeout of NO_TIMEOUT waits until a socket is readable
+	int  wait(unsigned int ms);
+
+	// As above, but also wakes at the deadline on the CFrameClock clock, if not zero
+	int  wait(unsigned int ms, uint64_t deadline);
+
+	// May be called from any thread to end the current or next wait early
+	void wake();
+
+	void close();
+
+private:
+	std::vector<const CUDPSocket*> m_sockets;
+#if defined(_WIN32) || defined(_WIN64)
+	std::atomic<bool>   m_woken;
+#else
+	std::vector<unsigned int> m_generations;
+	int                 m_epollFd;
+	int                 m_timerFd;
+	int                 m_wakeFd;
+
+	bool update();
+
+	int  poll(const struct itimerspec& its, int flags);
+#endif
+};
+
+#endif
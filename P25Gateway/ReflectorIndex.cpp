@@ -0,0 +1,134 @@
+/*
+ *   Copyright (C) 2026 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "ReflectorIndex.h"
+
+#include <cstring>
+
+CAddressKey::CAddressKey() :
+m_family(AF_UNSPEC),
+m_port(0U)
+{
+	::memset(m_addr, 0x00U, sizeof(m_addr));
+}
+
+CAddressKey CAddressKey::create(const sockaddr_storage& addr, unsigned int addrLen)
+{
+	CAddressKey key;
+
+	if (addrLen == 0U)
+		return key;
+
+	switch (addr.ss_family) {
+	case AF_INET: {
+			const struct sockaddr_in* in4 = (const struct sockaddr_in*)&addr;
+			key.m_family = AF_INET;
+			key.m_port   = in4->sin_port;
+			::memcpy(key.m_addr, &in4->sin_addr, 4U);
+		}
+		break;
+
+	case AF_INET6: {
+			const struct sockaddr_in6* in6 = (const struct sockaddr_in6*)&addr;
+			key.m_port = in6->sin6_port;
+			if (IN6_IS_ADDR_V4MAPPED(&in6->sin6_addr)) {
+				key.m_family = AF_INET;
+				::memcpy(key.m_addr, ((const uint8_t*)&in6->sin6_addr) + 12U, 4U);
+			} else {
+				key.m_family = AF_INET6;
+				::memcpy(key.m_addr, &in6->sin6_addr, 16U);
+			}
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	return key;
+}
+
+bool CAddressKey::operator==(const CAddressKey& key) const
+{
+	return (m_family == key.m_family) && (m_port == key.m_port) && (::memcmp(m_addr, key.m_addr, sizeof(m_addr)) == 0);
+}
+
+size_t CAddressKeyHash::operator()(const CAddressKey& key) const
+{
+	// FNV-1a over the port and the address, the family is implied by the address length
+	uint32_t hash = 0x811C9DC5U;
+
+	hash = (hash ^ (key.m_port & 0xFFU)) * 0x01000193U;
+	hash = (hash ^ (key.m_port >> 8))    * 0x01000193U;
+
+	unsigned int length = (key.m_family == AF_INET6) ? 16U : 4U;
+	for (unsigned int i = 0U; i < length; i++)
+		hash = (hash ^ key.m_addr[i]) * 0x01000193U;
+
+	return size_t(hash);
+}
+
+CReflectorIndex::CReflectorIndex() :
+m_static(),
+m_current4(),
+m_current6()
+{
+}
+
+void CReflectorIndex::add(const CP25Reflector& reflector)
+{
+	// The first talkgroup using an address wins, as it did with the linear search
+	if (reflector.hasIPv4())
+		m_static.insert(std::make_pair(CAddressKey::create(reflector.IPv4.m_addr, reflector.IPv4.m_addrLen), &reflector));
+
+	if (reflector.hasIPv6())
+		m_static.insert(std::make_pair(CAddressKey::create(reflector.IPv6.m_addr, reflector.IPv6.m_addrLen), &reflector));
+}
+
+void CReflectorIndex::setCurrent(const CP25Reflector& reflector)
+{
+	if (reflector.isEmpty()) {
+		m_current4 = CAddressKey();
+		m_current6 = CAddressKey();
+		return;
+	}
+
+	m_current4 = CAddressKey::create(reflector.IPv4.m_addr, reflector.IPv4.m_addrLen);
+	m_current6 = CAddressKey::create(reflector.IPv6.m_addr, reflector.IPv6.m_addrLen);
+}
+
+const CP25Reflector* CReflectorIndex::find(const sockaddr_storage& addr, bool& current) const
+{
+	CAddressKey key = CAddressKey::create(addr, sizeof(sockaddr_storage));
+
+	current = (key.m_family != AF_UNSPEC) && ((key == m_current4) || (key == m_current6));
+
+	std::unordered_map<CAddressKey, const CP25Reflector*, CAddressKeyHash>::const_iterator it = m_static.find(key);
+	if (it == m_static.cend())
+		return nullptr;
+
+	return it->second;
+}
+
+void CReflectorIndex::clear()
+{
+	m_static.clear();
+
+	m_current4 = CAddressKey();
+	m_current6 = CAddressKey();
+}
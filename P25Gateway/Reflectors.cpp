@@ -1,5 +1,5 @@
 /*
-*   Copyright (C) 2016,2018,2020,2025 by Jonathan Naylor G4KLX
+*   Copyright (C) 2016,2018,2020,2025,2026 by Jonathan Naylor G4KLX
 *
 *   This program is free software; you can redistribute it and/or modify
 *   it under the terms of the GNU General Public License as published by
@@ -17,6 +17,8 @@
 */
 
 #include "Reflectors.h"
+#include "StopWatch.h"
+#include "Timer.h"
 #include "Log.h"
 
 #include <fstream>
@@ -28,24 +30,136 @@
 #include <cassert>
 #include <cstring>
 #include <cctype>
+#include <ctime>
 
-CReflectors::CReflectors(const std::string& hostsFile1, const std::string& hostsFile2, unsigned int reloadTime) :
+#include <sys/stat.h>
+
+// Everything is looked up again at least once a day, even if unchanged
+const time_t FULL_LOAD_INTERVAL = 24 * 3600;
+
+// Marks an unused slot in the talkgroup index, TG0 is never stored so at
+// most 0xFFFF entries exist and their offsets are always below this value
+const uint16_t NO_REFLECTOR = 0xFFFFU;
+
+CReflectorTable::CReflectorTable() :
+m_reflectors(),
+m_index(P25_TG_COUNT, NO_REFLECTOR)
+{
+}
+
+void CReflectorTable::add(const CP25Reflector& reflector)
+{
+	assert(reflector.m_id < P25_TG_COUNT);
+
+	if (reflector.isEmpty())
+		return;
+
+	// The first entry for a talkgroup wins, as it did with the linear search
+	if (m_index[reflector.m_id] != NO_REFLECTOR)
+		return;
+
+	m_index[reflector.m_id] = uint16_t(m_reflectors.size());
+	m_reflectors.push_back(reflector);
+}
+
+const CP25Reflector* CReflectorTable::find(unsigned int id) const
+{
+	if (id >= P25_TG_COUNT)
+		return nullptr;
+
+	uint16_t n = m_index[id];
+	if (n == NO_REFLECTOR)
+		return nullptr;
+
+	return &m_reflectors[n];
+}
+
+unsigned int CReflectorTable::size() const
+{
+	return (unsigned int)m_reflectors.size();
+}
+
+CReflectors::CReflectors(const std::string& hostsFile1, const std::string& hostsFile2, unsigned int reloadTime, unsigned int resolverThreads, unsigned int resolverTimeout) :
+CThread(),
 m_hostsFile1(hostsFile1),
 m_hostsFile2(hostsFile2),
 m_parrotAddress(),
 m_parrotPort(0U),
 m_p252dmrAddress(),
 m_p252dmrPort(0U),
-m_reflectors(),
-m_timer(1000U, reloadTime * 60U)
+m_reloadTime(reloadTime),
+m_resolver(resolverThreads, resolverTimeout),
+m_table(),
+m_resolved(),
+m_failed(0U),
+m_hostsFile1State(),
+m_hostsFile2State(),
+m_lastFullLoad(0),
+m_revalidate(false),
+m_watcher(),
+m_running(false)
 {
-	if (reloadTime > 0U)
-		m_timer.start();
 }
 
 CReflectors::~CReflectors()
 {
-	remove();
+}
+
+CHostsFileState::CHostsFileState() :
+m_valid(false),
+m_mtime(0),
+m_size(0U),
+m_hash(0U)
+{
+}
+
+bool CHostsFileState::hasChanged(const std::string& fileName)
+{
+	struct stat st;
+	if (::stat(fileName.c_str(), &st) != 0) {
+		bool changed = m_valid;
+		m_valid = false;
+		return changed;
+	}
+
+	// The cheap check first, a rewrite with the same contents only costs a read
+	if (m_valid && (st.st_mtime == m_mtime) && (uint64_t(st.st_size) == m_size))
+		return false;
+
+	FILE* fp = ::fopen(fileName.c_str(), "rb");
+	if (fp == nullptr) {
+		bool changed = m_valid;
+		m_valid = false;
+		return changed;
+	}
+
+	// 64-bit FNV-1a
+	uint64_t hash = 0xCBF29CE484222325ULL;
+
+	unsigned char buffer[4096U];
+	size_t n;
+	while ((n = ::fread(buffer, 1U, sizeof(buffer), fp)) > 0U) {
+		for (size_t i = 0U; i < n; i++) {
+			hash ^= buffer[i];
+			hash *= 0x100000001B3ULL;
+		}
+	}
+
+	::fclose(fp);
+
+	bool changed = !m_valid || (hash != m_hash);
+
+	m_valid = true;
+	m_mtime = st.st_mtime;
+	m_size  = uint64_t(st.st_size);
+	m_hash  = hash;
+
+	return changed;
+}
+
+std::string CReflectors::CReflectorHost::key() const
+{
+	return std::to_string(m_id) + " " + m_ipv4Host + " " + m_ipv6Host + " " + m_anyHost + " " + std::to_string(m_port);
 }
 
 void CReflectors::setParrot(const std::string& address, unsigned short port)
@@ -60,90 +174,287 @@ void CReflectors::setP252DMR(const std::string& address, unsigned short port)
 	m_p252dmrPort    = port;
 }
 
-bool CReflectors::load()
+void CReflectors::setCache(const std::string& fileName, unsigned int time)
 {
-	// Clear out the old reflector list
-	remove();
+	m_resolver.setCache(fileName, time * 60U);
+}
 
-	bool ret = parseJSON(m_hostsFile1);
-	if (!ret)
+bool CReflectors::load(bool force)
+{
+	time_t now = ::time(nullptr);
+
+	// Addresses are only kept for so long before everything is looked up again
+	if ((now - m_lastFullLoad) >= FULL_LOAD_INTERVAL)
+		force = true;
+
+	// Both files are always checked so that their recorded state stays current
+	bool changed1 = m_hostsFile1State.hasChanged(m_hostsFile1);
+	bool changed2 = m_hostsFile2State.hasChanged(m_hostsFile2);
+	if (!force && !changed1 && !changed2 && (std::atomic_load(&m_table) != nullptr)) {
+		if (m_failed == 0U) {
+			LogDebug("The P25 hosts files are unchanged");
+			return true;
+		}
+
+		// Entries that failed to resolve are left out of m_resolved, so only they are looked up again
+		LogInfo("Retrying the %u P25 reflectors that could not be resolved", m_failed);
+	}
+
+	std::vector<CReflectorHost> hosts;
+
+	bool ret = parseJSON(m_hostsFile1, hosts);
+	if (!ret) {
+		LogWarning("Keeping the existing reflector list");
 		return false;
+	}
 
-	parseHosts(m_hostsFile2);
+	parseHosts(m_hostsFile2, hosts);
 
-	size_t size = m_reflectors.size();
-	LogInfo("Loaded %u P25 reflectors", size);
+	// Only entries that are new or have changed since the last load are looked up
+	std::vector<CResolverRequest> requests;
+	unsigned int unchanged = 0U;
 
-	// Add the Parrot entry
+	for (auto& host : hosts) {
+		if (!force && (m_resolved.count(host.key()) > 0U)) {
+			unchanged++;
+			continue;
+		}
+
+		if (!host.m_ipv4Host.empty()) {
+			host.m_ipv4 = int(requests.size());
+			requests.push_back(CResolverRequest(host.m_ipv4Host, host.m_port));
+		}
+
+		if (!host.m_ipv6Host.empty()) {
+			host.m_ipv6 = int(requests.size());
+			requests.push_back(CResolverRequest(host.m_ipv6Host, host.m_port));
+		}
+
+		if (!host.m_anyHost.empty()) {
+			host.m_any = int(requests.size());
+			requests.push_back(CResolverRequest(host.m_anyHost, host.m_port));
+		}
+	}
+
+	int parrot = -1;
 	if (m_parrotPort > 0U) {
-		sockaddr_storage addr;
-		unsigned int addrLen;
-		if (CUDPSocket::lookup(m_parrotAddress, m_parrotPort, addr, addrLen) == 0) {
-			CP25Reflector* refl = new CP25Reflector;
-			refl->m_id           = 10U;
-			refl->IPv4.m_addr    = addr;
-			refl->IPv4.m_addrLen = addrLen;
-			refl->IPv6.m_addrLen = 0U;
-			m_reflectors.push_back(refl);
-			LogInfo("Loaded P25 parrot (TG%u)", refl->m_id);
+		parrot = int(requests.size());
+		requests.push_back(CResolverRequest(m_parrotAddress, m_parrotPort));
+	}
+
+	int p252dmr = -1;
+	if (m_p252dmrPort > 0U) {
+		p252dmr = int(requests.size());
+		requests.push_back(CResolverRequest(m_p252dmrAddress, m_p252dmrPort));
+	}
+
+	// Every address is looked up at once, the table is then built in file order.
+	// The first load may use expired cache entries to get going without waiting
+	// on DNS, they are then refreshed by the reload thread.
+	if (m_resolver.resolve(requests, std::atomic_load(&m_table) == nullptr))
+		m_revalidate = true;
+
+	// Build a complete new table, the current one stays in use until it is ready
+	CReflectorTable* table = new CReflectorTable;
+	std::unordered_map<std::string, CP25Reflector> resolved;
+	unsigned int failed = 0U;
+
+	for (const auto& host : hosts) {
+		std::string key = host.key();
+
+		if ((host.m_ipv4 < 0) && (host.m_ipv6 < 0) && (host.m_any < 0)) {
+			const CP25Reflector& refl = m_resolved.at(key);
+			table->add(refl);
+			resolved[key] = refl;
+			continue;
+		}
+
+		CP25Reflector refl;
+		refl.m_id = host.m_id;
+
+		bool complete = true;
+
+		if (host.m_ipv4 >= 0) {
+			const CResolverRequest& request = requests[host.m_ipv4];
+			if (request.isResolved()) {
+				refl.IPv4.m_addr    = request.m_addr;
+				refl.IPv4.m_addrLen = request.m_addrLen;
+			} else {
+				LogWarning("Unable to resolve the address of %s", request.m_host.c_str());
+				complete = false;
+			}
+		}
+
+		if (host.m_ipv6 >= 0) {
+			const CResolverRequest& request = requests[host.m_ipv6];
+			if (request.isResolved()) {
+				refl.IPv6.m_addr    = request.m_addr;
+				refl.IPv6.m_addrLen = request.m_addrLen;
+			} else {
+				LogWarning("Unable to resolve the address of %s", request.m_host.c_str());
+				complete = false;
+			}
+		}
+
+		if (host.m_any >= 0) {
+			const CResolverRequest& request = requests[host.m_any];
+			if (request.isResolved()) {
+				switch (request.m_addr.ss_family) {
+				case AF_INET:
+					refl.IPv4.m_addr    = request.m_addr;
+					refl.IPv4.m_addrLen = request.m_addrLen;
+					break;
+				case AF_INET6:
+					refl.IPv6.m_addr    = request.m_addr;
+					refl.IPv6.m_addrLen = request.m_addrLen;
+					break;
+				default:
+					LogWarning("Unknown address family for %s", request.m_host.c_str());
+					break;
+				}
+			} else {
+				LogWarning("Unable to resolve the address of %s", request.m_host.c_str());
+				complete = false;
+			}
+		}
+
+		if (refl.hasIPv4() || refl.hasIPv6())
+			table->add(refl);
+
+		if (complete)
+			resolved[key] = refl;
+		else
+			failed++;
+	}
+
+	LogInfo("Loaded %u P25 reflectors, %u unchanged", table->size(), unchanged);
+
+	// Add the Parrot entry
+	if (parrot >= 0) {
+		const CResolverRequest& request = requests[parrot];
+		if (request.isResolved()) {
+			CP25Reflector refl;
+			refl.m_id           = 10U;
+			refl.IPv4.m_addr    = request.m_addr;
+			refl.IPv4.m_addrLen = request.m_addrLen;
+			table->add(refl);
+			LogInfo("Loaded P25 parrot (TG%u)", refl.m_id);
 		} else {
 			LogWarning("Unable to resolve the address of the Parrot");
+			failed++;
 		}
 	}
 
 	// Add the P252DMR entry
-	if (m_p252dmrPort > 0U) {
-		sockaddr_storage addr;
-		unsigned int addrLen;
-		if (CUDPSocket::lookup(m_p252dmrAddress, m_p252dmrPort, addr, addrLen) == 0) {
-			CP25Reflector* refl = new CP25Reflector;
-			refl->m_id           = 20U;
-			refl->IPv4.m_addr    = addr;
-			refl->IPv4.m_addrLen = addrLen;
-			refl->IPv6.m_addrLen = 0U;
-			m_reflectors.push_back(refl);
-			LogInfo("Loaded P252DMR (TG%u)", refl->m_id);
+	if (p252dmr >= 0) {
+		const CResolverRequest& request = requests[p252dmr];
+		if (request.isResolved()) {
+			CP25Reflector refl;
+			refl.m_id           = 20U;
+			refl.IPv4.m_addr    = request.m_addr;
+			refl.IPv4.m_addrLen = request.m_addrLen;
+			table->add(refl);
+			LogInfo("Loaded P252DMR (TG%u)", refl.m_id);
 		} else {
 			LogWarning("Unable to resolve the address of P252DMR");
+			failed++;
 		}
 	}
 
-	size = m_reflectors.size();
-	if (size == 0U)
+	if (table->size() == 0U) {
+		delete table;
 		return false;
+	}
+
+	// A reader still using the old table keeps it alive until it is done
+	std::atomic_store(&m_table, std::shared_ptr<const CReflectorTable>(table));
+
+	m_resolved.swap(resolved);
+	m_failed = failed;
+	if (force)
+		m_lastFullLoad = now;
 
 	return true;
 }
 
-CP25Reflector* CReflectors::find(unsigned int id)
+void CReflectors::start()
 {
-	for (std::vector<CP25Reflector*>::iterator it = m_reflectors.begin(); it != m_reflectors.end(); ++it) {
-		if (id == (*it)->m_id)
-			return *it;
-	}
+	// Without a watcher the timed reloads and revalidation still run
+	if (!m_watcher.open())
+		LogWarning("Unable to watch the P25 hosts files for changes");
+
+	// Both files are always added, they may each live in a different directory
+	bool watching1 = m_watcher.add(m_hostsFile1);
+	bool watching2 = m_watcher.add(m_hostsFile2);
 
-	return nullptr;
+	if (watching1 || watching2 || (m_reloadTime > 0U) || m_revalidate)
+		m_running = run();
 }
 
-void CReflectors::clock(unsigned int ms)
+void CReflectors::entry()
 {
-	m_timer.clock(ms);
+	LogInfo("Started the reflector reload thread");
+
+	CTimer timer(1000U, 60U * m_reloadTime);
+	if (m_reloadTime > 0U)
+		timer.start();
+
+	CStopWatch stopWatch;
+	stopWatch.start();
+
+	for (;;) {
+		// Addresses taken from an expired cache entry are looked up again straight away
+		if (m_revalidate) {
+			m_revalidate = false;
+			LogInfo("Revalidating the cached reflector addresses");
+			load(true);
+		}
 
-	if (m_timer.isRunning() && m_timer.hasExpired()) {
-		load();
-		m_timer.start();
+		WATCH_RESULT result = m_watcher.wait(timer.getRemainingMS());
+		if (result == WATCH_RESULT::STOPPED)
+			break;
+
+		timer.clock(stopWatch.elapsed());
+		stopWatch.start();
+
+		if (result == WATCH_RESULT::CHANGED) {
+			LogInfo("A P25 hosts file has changed");
+			load();
+		} else if (timer.isRunning() && timer.hasExpired()) {
+			load();
+			timer.start();
+		}
 	}
+
+	LogInfo("Stopped the reflector reload thread");
 }
 
-void CReflectors::remove()
+void CReflectors::stop()
 {
-	for (std::vector<CP25Reflector*>::iterator it = m_reflectors.begin(); it != m_reflectors.end(); ++it)
-		delete* it;
+	if (!m_running)
+		return;
 
-	m_reflectors.clear();
+	m_watcher.stop();
+
+	wait();
 }
 
-bool CReflectors::parseJSON(const std::string& fileName)
+bool CReflectors::find(unsigned int id, CP25Reflector& reflector) const
+{
+	std::shared_ptr<const CReflectorTable> table = std::atomic_load(&m_table);
+	if (table == nullptr)
+		return false;
+
+	const CP25Reflector* found = table->find(id);
+	if (found == nullptr)
+		return false;
+
+	reflector = *found;
+
+	return true;
+}
+
+bool CReflectors::parseJSON(const std::string& fileName, std::vector<CReflectorHost>& hosts)
 {
 	try {
 		std::fstream file(fileName);
@@ -154,8 +465,8 @@ bool CReflectors::parseJSON(const std::string& fileName)
 		if (!hasData)
 			throw;
 
-		nlohmann::json::array_t hosts = data["reflectors"];
-		for (const auto& it : hosts) {
+		nlohmann::json::array_t reflectors = data["reflectors"];
+		for (const auto& it : reflectors) {
 			unsigned int tg = it["designator"];
 			if (tg > 0xFFFFU) {
 				LogWarning("P25 Talkgroups can only be 16 bits. %u is too large", tg);
@@ -164,39 +475,20 @@ bool CReflectors::parseJSON(const std::string& fileName)
 
 			unsigned short port = it["port"];
 
-			sockaddr_storage addr_v4    = sockaddr_storage();
-			unsigned int     addrLen_v4 = 0U;
+			CReflectorHost host;
+			host.m_id   = tg;
+			host.m_port = port;
 
 			bool isNull = it["ipv4"].is_null();
-			if (!isNull) {
-				std::string ipv4 = it["ipv4"];
-				if (!CUDPSocket::lookup(ipv4, port, addr_v4, addrLen_v4) == 0) {
-					LogWarning("Unable to resolve the address of %s", ipv4.c_str());
-					addrLen_v4 = 0U;
-				}
-			}
-
-			sockaddr_storage addr_v6    = sockaddr_storage();
-			unsigned int     addrLen_v6 = 0U;
+			if (!isNull)
+				host.m_ipv4Host = it["ipv4"];
 
 			isNull = it["ipv6"].is_null();
-			if (!isNull) {
-				std::string ipv6 = it["ipv6"];
-				if (!CUDPSocket::lookup(ipv6, port, addr_v6, addrLen_v6) == 0) {
-					LogWarning("Unable to resolve the address of %s", ipv6.c_str());
-					addrLen_v6 = 0U;
-				}
-			}
+			if (!isNull)
+				host.m_ipv6Host = it["ipv6"];
 
-			if ((addrLen_v4 > 0U) || (addrLen_v6 > 0U)) {
-				CP25Reflector* refl = new CP25Reflector;
-				refl->m_id           = tg;
-				refl->IPv4.m_addr    = addr_v4;
-				refl->IPv4.m_addrLen = addrLen_v4;
-				refl->IPv6.m_addr    = addr_v6;
-				refl->IPv6.m_addrLen = addrLen_v6;
-				m_reflectors.push_back(refl);
-			}
+			if (!host.m_ipv4Host.empty() || !host.m_ipv6Host.empty())
+				hosts.push_back(host);
 		}
 	}
 	catch (...) {
@@ -207,7 +499,7 @@ bool CReflectors::parseJSON(const std::string& fileName)
 	return true;
 }
 
-bool CReflectors::parseHosts(const std::string& fileName)
+bool CReflectors::parseHosts(const std::string& fileName, std::vector<CReflectorHost>& hosts)
 {
 	FILE* fp = ::fopen(fileName.c_str(), "rt");
 	if (fp == nullptr) {
@@ -236,33 +528,11 @@ bool CReflectors::parseHosts(const std::string& fileName)
 			continue;
 		}
 
-		sockaddr_storage addr;
-		unsigned int addrLen;
-		if (CUDPSocket::lookup(host, port, addr, addrLen) == 0) {
-			CP25Reflector* refl = nullptr;
-			switch (addr.ss_family) {
-			case AF_INET:
-				refl = new CP25Reflector;
-				refl->m_id           = tg;
-				refl->IPv4.m_addr    = addr;
-				refl->IPv4.m_addrLen = addrLen;
-				m_reflectors.push_back(refl);
-				break;
-			case AF_INET6:
-				refl = new CP25Reflector;
-				refl->m_id           = tg;
-				refl->IPv6.m_addr    = addr;
-				refl->IPv6.m_addrLen = addrLen;
-				m_reflectors.push_back(refl);
-				break;
-			default:
-				LogWarning("Unknown address family for %s", host.c_str());
-				break;
-			}
-		}
-		else {
-			LogWarning("Unable to resolve the address of %s", host.c_str());
-		}
+		CReflectorHost entry;
+		entry.m_id      = tg;
+		entry.m_port    = port;
+		entry.m_anyHost = host;
+		hosts.push_back(entry);
 	}
 
 	::fclose(fp);
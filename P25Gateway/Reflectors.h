@@ -1,5 +1,5 @@
 /*
-*   Copyright (C) 2016,2018,2020,2025 by Jonathan Naylor G4KLX
+*   Copyright (C) 2016,2018,2020,2025,2026 by Jonathan Naylor G4KLX
 *
 *   This program is free software; you can redistribute it and/or modify
 *   it under the terms of the GNU General Public License as published by
@@ -20,12 +20,21 @@
 #define	Reflectors_H
 
 #include "UDPSocket.h"
-#include "Timer.h"
+#include "FileWatcher.h"
+#include "Resolver.h"
+#include "Thread.h"
 
+#include <unordered_map>
 #include <vector>
 #include <string>
+#include <memory>
 
+#include <cstdint>
 #include <cstring>
+#include <ctime>
+
+// P25 talkgroups are 16 bits, so every one of them has a slot in the index
+const unsigned int P25_TG_COUNT = 0x10000U;
 
 class CP25Reflector {
 public:
@@ -98,33 +107,106 @@ public:
 	}
 };
 
-class CReflectors {
+// An immutable set of reflectors once published, indexed directly by talkgroup
+class CReflectorTable {
+public:
+	CReflectorTable();
+
+	void add(const CP25Reflector& reflector);
+
+	const CP25Reflector* find(unsigned int id) const;
+
+	unsigned int size() const;
+
+private:
+	std::vector<CP25Reflector> m_reflectors;
+	std::vector<uint16_t>      m_index;
+};
+
+// Detects a changed hosts file from its modification time and size, and then its contents
+class CHostsFileState {
+public:
+	CHostsFileState();
+
+	bool hasChanged(const std::string& fileName);
+
+private:
+	bool     m_valid;
+	time_t   m_mtime;
+	uint64_t m_size;
+	uint64_t m_hash;
+};
+
+class CReflectors : public CThread {
 public:
-	CReflectors(const std::string& hostsFile1, const std::string& hostsFile2, unsigned int reloadTime);
-	~CReflectors();
+	CReflectors(const std::string& hostsFile1, const std::string& hostsFile2, unsigned int reloadTime, unsigned int resolverThreads, unsigned int resolverTimeout);
+	virtual ~CReflectors();
 
 	void setParrot(const std::string& address, unsigned short port);
 	void setP252DMR(const std::string& address, unsigned short port);
+	void setCache(const std::string& fileName, unsigned int time);
+
+	// Does nothing unless a hosts file has changed, or force is set
+	bool load(bool force = false);
+
+	// Starts the reload thread, which waits for the hosts files to change, the
+	// reload time to expire, or for cached addresses that need refreshing
+	void start();
 
-	bool load();
+	virtual void entry();
 
-	CP25Reflector* find(unsigned int id);
+	void stop();
 
-	void clock(unsigned int ms);
+	// Copies the entry out of the current table, as it may be replaced at any time
+	bool find(unsigned int id, CP25Reflector& reflector) const;
 
 private:
+	// A hosts file entry, the indices refer to the resolver requests when it is looked up
+	struct CReflectorHost {
+		CReflectorHost() :
+		m_id(0U),
+		m_port(0U),
+		m_ipv4Host(),
+		m_ipv6Host(),
+		m_anyHost(),
+		m_ipv4(-1),
+		m_ipv6(-1),
+		m_any(-1)
+		{
+		}
+
+		std::string key() const;
+
+		unsigned int   m_id;
+		unsigned short m_port;
+		std::string    m_ipv4Host;
+		std::string    m_ipv6Host;
+		std::string    m_anyHost;
+		int            m_ipv4;
+		int            m_ipv6;
+		int            m_any;
+	};
+
 	std::string  m_hostsFile1;
 	std::string  m_hostsFile2;
 	std::string  m_parrotAddress;
 	unsigned short m_parrotPort;
 	std::string  m_p252dmrAddress;
 	unsigned short m_p252dmrPort;
-	std::vector<CP25Reflector*> m_reflectors;
-	CTimer       m_timer;
-
-	void remove();
-	bool parseJSON(const std::string& fileName);
-	bool parseHosts(const std::string& fileName);
+	unsigned int m_reloadTime;
+	CResolver    m_resolver;
+	std::shared_ptr<const CReflectorTable> m_table;
+	std::unordered_map<std::string, CP25Reflector> m_resolved;
+	unsigned int m_failed;
+	CHostsFileState m_hostsFile1State;
+	CHostsFileState m_hostsFile2State;
+	time_t       m_lastFullLoad;
+	bool         m_revalidate;
+	CFileWatcher m_watcher;
+	bool         m_running;
+
+	bool parseJSON(const std::string& fileName, std::vector<CReflectorHost>& hosts);
+	bool parseHosts(const std::string& fileName, std::vector<CReflectorHost>& hosts);
 };
 
 #endif
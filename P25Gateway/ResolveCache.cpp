@@ -0,0 +1,193 @@
+/*
+ *   Copyright (C) 2026 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "ResolveCache.h"
+#include "Log.h"
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+const uint32_t CACHE_MAGIC   = 0x43353250U;		// "P25C"
+const uint32_t CACHE_VERSION = 2U;
+
+// Entries that have not been refreshed for a week are dropped
+const uint64_t CACHE_MAX_AGE = 7U * 24U * 3600U;
+
+struct CCacheHeader {
+	uint32_t m_magic;
+	uint32_t m_version;
+	uint32_t m_count;
+};
+
+// Laid out without any implicit padding, so that it is the same size on every ABI
+struct CCacheRecord {
+	uint64_t m_time;
+	uint32_t m_ttl;
+	uint32_t m_addrLen;
+	uint16_t m_port;
+	uint16_t m_hostLen;
+	uint32_t m_reserved;
+};
+
+CResolveCache::CResolveCache(const std::string& fileName, unsigned int ttl) :
+m_fileName(fileName),
+m_ttl(ttl),
+m_entries(),
+m_changed(false)
+{
+}
+
+bool CResolveCache::load()
+{
+	FILE* fp = ::fopen(m_fileName.c_str(), "rb");
+	if (fp == nullptr) {
+		LogInfo("No resolver cache file %s", m_fileName.c_str());
+		return false;
+	}
+
+	CCacheHeader header;
+	if ((::fread(&header, sizeof(CCacheHeader), 1U, fp) != 1U) || (header.m_magic != CACHE_MAGIC) || (header.m_version != CACHE_VERSION)) {
+		LogWarning("Ignoring the invalid resolver cache file %s", m_fileName.c_str());
+		::fclose(fp);
+		return false;
+	}
+
+	uint64_t now = uint64_t(::time(nullptr));
+
+	for (uint32_t i = 0U; i < header.m_count; i++) {
+		CCacheRecord record;
+		if (::fread(&record, sizeof(CCacheRecord), 1U, fp) != 1U)
+			break;
+
+		if (record.m_addrLen > sizeof(sockaddr_storage))
+			break;
+
+		CCacheEntry entry;
+		::memset(&entry.m_addr, 0x00U, sizeof(sockaddr_storage));
+		if (::fread(&entry.m_addr, 1U, record.m_addrLen, fp) != record.m_addrLen)
+			break;
+
+		entry.m_host.resize(record.m_hostLen);
+		if ((record.m_hostLen > 0U) && (::fread(&entry.m_host[0U], 1U, record.m_hostLen, fp) != record.m_hostLen))
+			break;
+
+		if ((record.m_time + CACHE_MAX_AGE) < now)
+			continue;
+
+		entry.m_port    = record.m_port;
+		entry.m_addrLen = record.m_addrLen;
+		entry.m_time    = record.m_time;
+		entry.m_ttl     = record.m_ttl;
+
+		m_entries[key(entry.m_host, entry.m_port)] = entry;
+	}
+
+	::fclose(fp);
+
+	LogInfo("Loaded %u addresses from the resolver cache", (unsigned int)m_entries.size());
+
+	return true;
+}
+
+bool CResolveCache::save()
+{
+	if (!m_changed)
+		return true;
+
+	// Write to a temporary file and rename it so that a crash never leaves a partial cache
+	std::string tempName = m_fileName + ".tmp";
+
+	FILE* fp = ::fopen(tempName.c_str(), "wb");
+	if (fp == nullptr) {
+		LogWarning("Unable to write the resolver cache file %s", tempName.c_str());
+		return false;
+	}
+
+	CCacheHeader header;
+	::memset(&header, 0x00U, sizeof(CCacheHeader));
+	header.m_magic   = CACHE_MAGIC;
+	header.m_version = CACHE_VERSION;
+	header.m_count   = uint32_t(m_entries.size());
+
+	bool ok = ::fwrite(&header, sizeof(CCacheHeader), 1U, fp) == 1U;
+
+	for (const auto& it : m_entries) {
+		const CCacheEntry& entry = it.second;
+
+		CCacheRecord record;
+		::memset(&record, 0x00U, sizeof(CCacheRecord));
+		record.m_time    = entry.m_time;
+		record.m_ttl     = entry.m_ttl;
+		record.m_port    = entry.m_port;
+		record.m_hostLen = uint16_t(entry.m_host.size());
+		record.m_addrLen = entry.m_addrLen;
+
+		ok = ok && (::fwrite(&record, sizeof(CCacheRecord), 1U, fp) == 1U);
+		ok = ok && (::fwrite(&entry.m_addr, 1U, entry.m_addrLen, fp) == entry.m_addrLen);
+		ok = ok && (::fwrite(entry.m_host.c_str(), 1U, entry.m_host.size(), fp) == entry.m_host.size());
+	}
+
+	ok = (::fclose(fp) == 0) && ok;
+
+	if (!ok || (::rename(tempName.c_str(), m_fileName.c_str()) != 0)) {
+		LogWarning("Unable to write the resolver cache file %s", m_fileName.c_str());
+		::remove(tempName.c_str());
+		return false;
+	}
+
+	m_changed = false;
+
+	return true;
+}
+
+bool CResolveCache::find(const std::string& host, unsigned short port, sockaddr_storage& addr, unsigned int& addrLen, bool& fresh) const
+{
+	std::unordered_map<std::string, CCacheEntry>::const_iterator it = m_entries.find(key(host, port));
+	if (it == m_entries.cend())
+		return false;
+
+	const CCacheEntry& entry = it->second;
+
+	addr    = entry.m_addr;
+	addrLen = entry.m_addrLen;
+
+	uint64_t now = uint64_t(::time(nullptr));
+	fresh = (entry.m_time + entry.m_ttl) > now;
+
+	return true;
+}
+
+void CResolveCache::add(const std::string& host, unsigned short port, const sockaddr_storage& addr, unsigned int addrLen)
+{
+	CCacheEntry& entry = m_entries[key(host, port)];
+
+	entry.m_host    = host;
+	entry.m_port    = port;
+	entry.m_addr    = addr;
+	entry.m_addrLen = addrLen;
+	entry.m_time    = uint64_t(::time(nullptr));
+	entry.m_ttl     = m_ttl;
+
+	m_changed = true;
+}
+
+std::string CResolveCache::key(const std::string& host, unsigned short port)
+{
+	return host + ":" + std::to_string(port);
+}
@@ -0,0 +1,61 @@
+/*
+ *   Copyright (C) 2026 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef	ResolveCache_H
+#define	ResolveCache_H
+
+#include "UDPSocket.h"
+
+#include <unordered_map>
+#include <string>
+
+#include <cstdint>
+
+// Remembers resolved host names across restarts in a small binary file.
+// An entry is fresh until its TTL runs out, after that it may still be
+// used while a new lookup is made.
+class CResolveCache {
+public:
+	CResolveCache(const std::string& fileName, unsigned int ttl);
+
+	bool load();
+	bool save();
+
+	bool find(const std::string& host, unsigned short port, sockaddr_storage& addr, unsigned int& addrLen, bool& fresh) const;
+
+	void add(const std::string& host, unsigned short port, const sockaddr_storage& addr, unsigned int addrLen);
+
+private:
+	struct CCacheEntry {
+		std::string      m_host;
+		unsigned short   m_port;
+		sockaddr_storage m_addr;
+		unsigned int     m_addrLen;
+		uint64_t         m_time;
+		uint32_t         m_ttl;
+	};
+
+	std::string  m_fileName;
+	unsigned int m_ttl;
+	std::unordered_map<std::string, CCacheEntry> m_entries;
+	bool         m_changed;
+
+	static std::string key(const std::string& host, unsigned short port);
+};
+
+#endif
@@ -0,0 +1,366 @@
+/*
+ *   Copyright (C) 2026 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "Resolver.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <arpa/inet.h>
+#endif
+
+CResolverRequest::CResolverRequest(const std::string& host, unsigned short port) :
+m_host(host),
+m_port(port),
+m_addr(),
+m_addrLen(0U)
+{
+}
+
+bool CResolverRequest::isResolved() const
+{
+	return m_addrLen > 0U;
+}
+
+CResolverWorker::CResolverWorker(CResolver& resolver) :
+CThread(),
+m_exited(false),
+m_resolver(resolver)
+{
+}
+
+void CResolverWorker::entry()
+{
+	m_resolver.process(*this);
+}
+
+CResolver::CResolver(unsigned int threads, unsigned int timeout) :
+m_cache(nullptr),
+m_threads(threads),
+m_timeout(timeout * 1000U),
+m_mutex(),
+m_queued(),
+m_finished(),
+m_queue(),
+m_workers(),
+m_active(0U),
+m_stuck(0U),
+m_stop(false)
+{
+	assert(timeout > 0U);
+}
+
+CResolver::~CResolver()
+{
+	stop();
+
+	delete m_cache;
+}
+
+void CResolver::setCache(const std::string& fileName, unsigned int ttl)
+{
+	delete m_cache;
+
+	m_cache = new CResolveCache(fileName, ttl);
+	m_cache->load();
+}
+
+bool CResolver::resolve(std::vector<CResolverRequest>& requests, bool useStale)
+{
+	bool stale = false;
+
+	std::vector<unsigned int> indices;
+	for (unsigned int i = 0U; i < requests.size(); i++) {
+		CResolverRequest& request = requests[i];
+
+		// Numeric addresses never need the resolver
+		if (parseNumeric(request.m_host, request.m_port, request.m_addr, request.m_addrLen))
+			continue;
+
+		if (m_cache != nullptr) {
+			bool fresh = false;
+			if (m_cache->find(request.m_host, request.m_port, request.m_addr, request.m_addrLen, fresh)) {
+				if (fresh)
+					continue;
+
+				if (useStale) {
+					stale = true;
+					continue;
+				}
+
+				request.m_addrLen = 0U;
+			}
+		}
+
+		indices.push_back(i);
+	}
+
+	lookup(requests, indices);
+
+	if (m_cache != nullptr) {
+		for (const auto& i : indices) {
+			CResolverRequest& request = requests[i];
+
+			if (request.isResolved()) {
+				m_cache->add(request.m_host, request.m_port, request.m_addr, request.m_addrLen);
+			} else {
+				// A failed lookup is better served by the last known address than by none
+				bool fresh = false;
+				if (m_cache->find(request.m_host, request.m_port, request.m_addr, request.m_addrLen, fresh))
+					LogWarning("Using the cached address of %s", request.m_host.c_str());
+			}
+		}
+
+		m_cache->save();
+	}
+
+	return stale;
+}
+
+void CResolver::lookup(std::vector<CResolverRequest>& requests, const std::vector<unsigned int>& indices)
+{
+	std::vector<std::shared_ptr<CResolverJob>> jobs(requests.size());
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	std::chrono::steady_clock::time_point queuedAt = std::chrono::steady_clock::now();
+
+	unsigned int queued = 0U;
+	for (const auto& i : indices) {
+		CResolverRequest& request = requests[i];
+
+		// Without a pool the lookups are done one at a time, as they used to be
+		if (m_threads == 0U) {
+			if (CUDPSocket::lookup(request.m_host, request.m_port, request.m_addr, request.m_addrLen) != 0)
+				request.m_addrLen = 0U;
+			continue;
+		}
+
+		std::shared_ptr<CResolverJob> job = std::make_shared<CResolverJob>();
+		job->m_host     = request.m_host;
+		job->m_port     = request.m_port;
+		job->m_addrLen  = 0U;
+		job->m_state    = JOB_STATE::QUEUED;
+		job->m_deadline = queuedAt + m_timeout;
+
+		m_queue.push_back(job);
+		jobs[i] = job;
+		queued++;
+	}
+
+	if (queued == 0U)
+		return;
+
+	while (((m_active - m_stuck) < std::min(m_threads, queued)) && (m_active < (2U * m_threads))) {
+		if (!spawn())
+			break;
+	}
+
+	// Without any worker to take them the lookups are done here, one at a time
+	if (m_active == m_stuck) {
+		for (const auto& job : jobs) {
+			if ((job == nullptr) || (job->m_state != JOB_STATE::QUEUED))
+				continue;
+
+			m_queue.erase(std::find(m_queue.begin(), m_queue.end(), job));
+
+			lock.unlock();
+			int ret = CUDPSocket::lookup(job->m_host, job->m_port, job->m_addr, job->m_addrLen);
+			lock.lock();
+
+			if (ret != 0)
+				job->m_addrLen = 0U;
+			job->m_state = JOB_STATE::DONE;
+		}
+	}
+
+	m_queued.notify_all();
+
+	for (;;) {
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		std::chrono::steady_clock::time_point deadline = now + m_timeout;
+		bool pending = false;
+
+		for (const auto& job : jobs) {
+			if (job == nullptr)
+				continue;
+
+			switch (job->m_state) {
+			case JOB_STATE::QUEUED:
+				// Still waiting for a worker, it is simply taken off the queue
+				if (now >= job->m_deadline) {
+					LogWarning("Timed out waiting to resolve the address of %s", job->m_host.c_str());
+					job->m_state = JOB_STATE::ABANDONED;
+					m_queue.erase(std::find(m_queue.begin(), m_queue.end(), job));
+				} else {
+					pending  = true;
+					deadline = std::min(deadline, job->m_deadline);
+				}
+				break;
+
+			case JOB_STATE::RUNNING:
+				if (now >= job->m_deadline) {
+					LogWarning("Timed out resolving the address of %s", job->m_host.c_str());
+					job->m_state = JOB_STATE::ABANDONED;
+					m_stuck++;
+
+					// The worker is blocked until getaddrinfo gives up, so let another one take its place
+					if (!m_queue.empty() && ((m_active - m_stuck) < m_threads) && (m_active < (2U * m_threads)) && spawn())
+						m_queued.notify_one();
+				} else {
+					pending  = true;
+					deadline = std::min(deadline, job->m_deadline);
+				}
+				break;
+
+			default:
+				break;
+			}
+		}
+
+		if (!pending)
+			break;
+
+		m_finished.wait_until(lock, deadline);
+	}
+
+	// Merge the results back in the original order
+	for (unsigned int i = 0U; i < requests.size(); i++) {
+		const std::shared_ptr<CResolverJob>& job = jobs[i];
+		if ((job != nullptr) && (job->m_state == JOB_STATE::DONE)) {
+			requests[i].m_addr    = job->m_addr;
+			requests[i].m_addrLen = job->m_addrLen;
+		}
+	}
+}
+
+void CResolver::stop()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	m_stop = true;
+	m_queue.clear();
+	m_queued.notify_all();
+
+	std::vector<CResolverWorker*> workers;
+	workers.swap(m_workers);
+
+	lock.unlock();
+
+	for (auto& worker : workers) {
+		worker->wait();
+		delete worker;
+	}
+}
+
+void CResolver::process(CResolverWorker& worker)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	for (;;) {
+		m_queued.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+		if (m_stop)
+			break;
+
+		std::shared_ptr<CResolverJob> job = m_queue.front();
+		m_queue.pop_front();
+
+		job->m_state = JOB_STATE::RUNNING;
+
+		std::string host    = job->m_host;
+		unsigned short port = job->m_port;
+
+		lock.unlock();
+
+		sockaddr_storage addr;
+		unsigned int addrLen = 0U;
+		int ret = CUDPSocket::lookup(host, port, addr, addrLen);
+
+		lock.lock();
+
+		if (job->m_state == JOB_STATE::RUNNING) {
+			if (ret == 0) {
+				job->m_addr    = addr;
+				job->m_addrLen = addrLen;
+			}
+
+			job->m_state = JOB_STATE::DONE;
+			m_finished.notify_all();
+		} else {
+			// The caller gave up on this lookup and may have started a replacement
+			m_stuck--;
+			if (m_active > m_threads)
+				break;
+		}
+	}
+
+	m_active--;
+	worker.m_exited = true;
+}
+
+bool CResolver::spawn()
+{
+	// Reap any workers that retired after being replaced
+	for (std::vector<CResolverWorker*>::iterator it = m_workers.begin(); it != m_workers.end();) {
+		if ((*it)->m_exited) {
+			(*it)->wait();
+			delete *it;
+			it = m_workers.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	CResolverWorker* worker = new CResolverWorker(*this);
+	if (!worker->run()) {
+		LogError("Unable to start a resolver thread");
+		delete worker;
+		return false;
+	}
+
+	m_workers.push_back(worker);
+	m_active++;
+
+	return true;
+}
+
+bool CResolver::parseNumeric(const std::string& host, unsigned short port, sockaddr_storage& addr, unsigned int& addrLen)
+{
+	::memset(&addr, 0x00U, sizeof(sockaddr_storage));
+
+	sockaddr_in* addr4 = (sockaddr_in*)&addr;
+	if (::inet_pton(AF_INET, host.c_str(), &addr4->sin_addr) == 1) {
+		addr4->sin_family = AF_INET;
+		addr4->sin_port   = htons(port);
+		addrLen = sizeof(sockaddr_in);
+		return true;
+	}
+
+	sockaddr_in6* addr6 = (sockaddr_in6*)&addr;
+	if (::inet_pton(AF_INET6, host.c_str(), &addr6->sin6_addr) == 1) {
+		addr6->sin6_family = AF_INET6;
+		addr6->sin6_port   = htons(port);
+		addrLen = sizeof(sockaddr_in6);
+		return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,116 @@
+/*
+ *   Copyright (C) 2026 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef	Resolver_H
+#define	Resolver_H
+
+#include "ResolveCache.h"
+#include "UDPSocket.h"
+#include "Thread.h"
+
+#include <condition_variable>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+
+class CResolverRequest {
+public:
+	CResolverRequest(const std::string& host, unsigned short port);
+
+	bool isResolved() const;
+
+	std::string      m_host;
+	unsigned short   m_port;
+	sockaddr_storage m_addr;
+	unsigned int     m_addrLen;
+};
+
+class CResolver;
+
+class CResolverWorker : public CThread {
+public:
+	CResolverWorker(CResolver& resolver);
+
+	virtual void entry();
+
+	bool m_exited;
+
+private:
+	CResolver& m_resolver;
+};
+
+// Resolves a batch of host names on a bounded pool of worker threads. A
+// lookup not finished within the timeout of being queued is abandoned, any
+// worker stuck in getaddrinfo is replaced, and the request is returned
+// unresolved.
+class CResolver {
+public:
+	CResolver(unsigned int threads, unsigned int timeout);
+	~CResolver();
+
+	// Addresses are remembered in the file and reused until the TTL, in seconds, runs out
+	void setCache(const std::string& fileName, unsigned int ttl);
+
+	// Fills in the address of each request, in place. Returns true if any
+	// came from an expired cache entry and should be looked up again.
+	bool resolve(std::vector<CResolverRequest>& requests, bool useStale = false);
+
+	void stop();
+
+private:
+	friend class CResolverWorker;
+
+	enum class JOB_STATE {
+		QUEUED,
+		RUNNING,
+		DONE,
+		ABANDONED
+	};
+
+	struct CResolverJob {
+		std::string      m_host;
+		unsigned short   m_port;
+		sockaddr_storage m_addr;
+		unsigned int     m_addrLen;
+		JOB_STATE        m_state;
+		std::chrono::steady_clock::time_point m_deadline;
+	};
+
+	CResolveCache*                m_cache;
+	unsigned int                  m_threads;
+	std::chrono::milliseconds     m_timeout;
+	std::mutex                    m_mutex;
+	std::condition_variable       m_queued;
+	std::condition_variable       m_finished;
+	std::deque<std::shared_ptr<CResolverJob>> m_queue;
+	std::vector<CResolverWorker*> m_workers;
+	unsigned int                  m_active;
+	unsigned int                  m_stuck;
+	bool                          m_stop;
+
+	void lookup(std::vector<CResolverRequest>& requests, const std::vector<unsigned int>& indices);
+	void process(CResolverWorker& worker);
+	bool spawn();
+
+	static bool parseNumeric(const std::string& host, unsigned short port, sockaddr_storage& addr, unsigned int& addrLen);
+};
+
+#endif
@@ -1,5 +1,5 @@
 /*
- *   Copyright (C) 2009-2014,2016,2020,2025 by Jonathan Naylor G4KLX
+ *   Copyright (C) 2009-2014,2016,2020,2025,2026 by Jonathan Naylor G4KLX
  *
  *   This program is free software; you can redistribute it and/or modify
  *   it under the terms of the GNU General Public License as published by
@@ -82,24 +82,31 @@ bool CRptNetwork::writePoll()
 	return m_socket.write(data, 11U, m_rptAddr, m_rptAddrLen);
 }
 
-unsigned int CRptNetwork::read(unsigned char* data, unsigned int length)
+unsigned int CRptNetwork::read(CUDPDatagram* datagrams, unsigned int count)
 {
-	assert(data != nullptr);
-	assert(length > 0U);
+	assert(datagrams != nullptr);
+	assert(count > 0U);
 
-	sockaddr_storage addr;
-	unsigned int addrLen = 0U;
-	int len = m_socket.read(data, length, addr, addrLen);
-	if (len <= 0)
+	int ret = m_socket.read(datagrams, count);
+	if (ret <= 0)
 		return 0U;
 
-	if (!CUDPSocket::match(addr, m_rptAddr))
-		return 0U;
+	// Drop anything that isn't from the repeater
+	unsigned int n = 0U;
+	for (int i = 0; i < ret; i++) {
+		if (!CUDPSocket::match(datagrams[i].m_addr, m_rptAddr))
+			continue;
 
-	if (m_debug)
-		CUtils::dump(1U, "Rpt Network Data Received", data, len);
+		if (m_debug)
+			CUtils::dump(1U, "Rpt Network Data Received", datagrams[i].m_data, datagrams[i].m_length);
+
+		if (int(n) != i)
+			datagrams[n] = datagrams[i];
+
+		n++;
+	}
 
-	return len;
+	return n;
 }
 
 void CRptNetwork::clock(unsigned int ms)
@@ -111,6 +118,16 @@ void CRptNetwork::clock(unsigned int ms)
 	}
 }
 
+unsigned int CRptNetwork::getRemainingMS()
+{
+	return m_timer.getRemainingMS();
+}
+
+bool CRptNetwork::registerSockets(CPoller& poller)
+{
+	return poller.add(m_socket);
+}
+
 void CRptNetwork::close()
 {
 	m_timer.stop();
@@ -1,5 +1,5 @@
 /*
- *   Copyright (C) 2009-2014,2016,2020 by Jonathan Naylor G4KLX
+ *   Copyright (C) 2009-2014,2016,2020,2026 by Jonathan Naylor G4KLX
  *
  *   This program is free software; you can redistribute it and/or modify
  *   it under the terms of the GNU General Public License as published by
@@ -20,6 +20,7 @@
 #define	RptNetwork_H
 
 #include "UDPSocket.h"
+#include "Poller.h"
 #include "Timer.h"
 
 #include <cstdint>
@@ -34,10 +35,14 @@ public:
 
 	bool write(const unsigned char* data, unsigned int length);
 
-	unsigned int read(unsigned char* data, unsigned int length);
+	unsigned int read(CUDPDatagram* datagrams, unsigned int count);
 
 	void clock(unsigned int ms);
 
+	unsigned int getRemainingMS();
+
+	bool registerSockets(CPoller& poller);
+
 	void close();
 
 private:
@@ -1,5 +1,5 @@
 /*
- *   Copyright (C) 2009,2010,2011,2014 by Jonathan Naylor G4KLX
+ *   Copyright (C) 2009,2010,2011,2014,2026 by Jonathan Naylor G4KLX
  *
  *   This program is free software; you can redistribute it and/or modify
  *   it under the terms of the GNU General Public License as published by
@@ -19,6 +19,9 @@
 #ifndef	Timer_H
 #define	Timer_H
 
+// Returned by getRemainingMS() when the timer is not running
+const unsigned int NO_TIMEOUT = 0xFFFFFFFFU;
+
 class CTimer {
 public:
 	CTimer(unsigned int ticksPerSec, unsigned int secs = 0U, unsigned int msecs = 0U);
@@ -40,6 +43,18 @@ public:
 		return (m_timeout - m_timer) / m_ticksPerSec;
 	}
 
+	unsigned int getRemainingMS()
+	{
+		if (m_timeout == 0U || m_timer == 0U)
+			return NO_TIMEOUT;
+
+		if (m_timer >= m_timeout)
+			return 0U;
+
+		// Round up so that a wait of this length always reaches the expiry
+		return (unsigned int)(((m_timeout - m_timer) * 1000ULL + m_ticksPerSec - 1U) / m_ticksPerSec);
+	}
+
 	bool isRunning()
 	{
 		return m_timer > 0U;
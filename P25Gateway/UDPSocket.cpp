@@ -1,5 +1,5 @@
 /*
- *   Copyright (C) 2006-2016,2020,2024,2025 by Jonathan Naylor G4KLX
+ *   Copyright (C) 2006-2016,2020,2024,2025,2026 by Jonathan Naylor G4KLX
  *
  *   This program is free software; you can redistribute it and/or modify
  *   it under the terms of the GNU General Public License as published by
@@ -36,6 +36,8 @@
 CUDPSocket::CUDPSocket(const std::string& address, unsigned short port) :
 m_localAddress(address),
 m_localPort(port),
+m_dualStack(false),
+m_generation(0U),
 #if defined(_WIN32) || defined(_WIN64)
 m_fd(INVALID_SOCKET),
 #else
@@ -48,6 +50,8 @@ m_af(AF_UNSPEC)
 CUDPSocket::CUDPSocket(unsigned short port) :
 m_localAddress(),
 m_localPort(port),
+m_dualStack(false),
+m_generation(0U),
 #if defined(_WIN32) || defined(_WIN64)
 m_fd(INVALID_SOCKET),
 #else
@@ -116,6 +120,12 @@ int CUDPSocket::lookup(const std::string& hostname, unsigned short port, sockadd
 
 bool CUDPSocket::match(const sockaddr_storage& addr1, const sockaddr_storage& addr2, IPMATCHTYPE type)
 {
+	// A dual stack socket reports IPv4 peers as IPv4-mapped IPv6 addresses
+	if ((addr1.ss_family == AF_INET6) && (addr2.ss_family == AF_INET))
+		return matchMapped(addr1, addr2, type);
+	if ((addr1.ss_family == AF_INET) && (addr2.ss_family == AF_INET6))
+		return matchMapped(addr2, addr1, type);
+
 	if (addr1.ss_family != addr2.ss_family)
 		return false;
 
@@ -154,9 +164,46 @@ bool CUDPSocket::match(const sockaddr_storage& addr1, const sockaddr_storage& ad
 	}
 }
 
-bool CUDPSocket::open(const sockaddr_storage& address)
+bool CUDPSocket::matchMapped(const sockaddr_storage& addr6, const sockaddr_storage& addr4, IPMATCHTYPE type)
+{
+	const struct sockaddr_in6* in6 = (const struct sockaddr_in6*)&addr6;
+	const struct sockaddr_in*  in  = (const struct sockaddr_in*)&addr4;
+
+	if (!IN6_IS_ADDR_V4MAPPED(&in6->sin6_addr))
+		return false;
+
+	if (::memcmp(&in6->sin6_addr.s6_addr[12U], &in->sin_addr.s_addr, 4U) != 0)
+		return false;
+
+	if (type == IPMATCHTYPE::ADDRESS_AND_PORT)
+		return in6->sin6_port == in->sin_port;
+
+	return true;
+}
+
+void CUDPSocket::mapIPv4(const sockaddr_storage& addr4, sockaddr_storage& addr6, unsigned int& addrLen6)
+{
+	assert(addr4.ss_family == AF_INET);
+
+	const struct sockaddr_in* in  = (const struct sockaddr_in*)&addr4;
+	struct sockaddr_in6*      in6 = (struct sockaddr_in6*)&addr6;
+
+	::memset(&addr6, 0x00U, sizeof(sockaddr_storage));
+
+	// ::ffff:a.b.c.d
+	in6->sin6_family = AF_INET6;
+	in6->sin6_port   = in->sin_port;
+	in6->sin6_addr.s6_addr[10U] = 0xFFU;
+	in6->sin6_addr.s6_addr[11U] = 0xFFU;
+	::memcpy(&in6->sin6_addr.s6_addr[12U], &in->sin_addr.s_addr, 4U);
+
+	addrLen6 = sizeof(struct sockaddr_in6);
+}
+
+bool CUDPSocket::open(const sockaddr_storage& address, bool dualStack)
 {
-	m_af = address.ss_family;
+	m_af        = address.ss_family;
+	m_dualStack = dualStack;
 
 	return open();
 }
@@ -226,6 +273,12 @@ bool CUDPSocket::open()
 		return false;
 	}
 
+#if defined(_WIN32) || defined(_WIN64)
+	// There is no MSG_DONTWAIT on Windows so make the socket itself non-blocking
+	u_long nonBlocking = 1UL;
+	::ioctlsocket(m_fd, FIONBIO, &nonBlocking);
+#endif
+
 	if (m_localPort > 0U) {
 		int reuse = 1;
 		if (::setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, (char *)&reuse, sizeof(reuse)) == -1) {
@@ -258,6 +311,19 @@ bool CUDPSocket::open()
 			return false;
 		}
 
+		if ((m_af == AF_INET6) && m_dualStack) {
+			int v6Only = 0;
+			if (::setsockopt(m_fd, IPPROTO_IPV6, IPV6_V6ONLY, (char *)&v6Only, sizeof(v6Only)) == -1) {
+#if defined(_WIN32) || defined(_WIN64)
+				LogError("Cannot make the IPv6 UDP socket on port %u dual stack, err: %lu", m_localPort, ::GetLastError());
+#else
+				LogError("Cannot make the IPv6 UDP socket on port %u dual stack, err: %d", m_localPort, errno);
+#endif
+				close();
+				return false;
+			}
+		}
+
 		if (::bind(m_fd, (sockaddr*)&addr, addrlen) == -1) {
 #if defined(_WIN32) || defined(_WIN64)
 			switch (m_af) {
@@ -293,7 +359,10 @@ bool CUDPSocket::open()
 			LogInfo("Opening an IPv4 UDP port on %hu", m_localPort);
 			break;
 		case AF_INET6:
-			LogInfo("Opening an IPv6 UDP port on %hu", m_localPort);
+			if (m_dualStack)
+				LogInfo("Opening a dual stack IPv6 UDP port on %hu", m_localPort);
+			else
+				LogInfo("Opening an IPv6 UDP port on %hu", m_localPort);
 			break;
 		default:
 			LogError("Unknown IP protocol - %d", m_af);
@@ -302,6 +371,8 @@ bool CUDPSocket::open()
 		}
 	}
 
+	m_generation++;
+
 	return true;
 }
 
@@ -318,60 +389,21 @@ int CUDPSocket::read(unsigned char* buffer, unsigned int length, sockaddr_storag
 		return 0;
 #endif
 
-	// Check that the readfrom() won't block
-	struct pollfd pfd;
-	pfd.fd      = m_fd;
-	pfd.events  = POLLIN;
-	pfd.revents = 0;
-
-	// Return immediately
-#if defined(_WIN32) || defined(_WIN64)
-	int ret = WSAPoll(&pfd, 1, 0);
-#else
-	int ret = ::poll(&pfd, 1, 0);
-#endif
-	if (ret < 0) {
-#if defined(_WIN32) || defined(_WIN64)
-		switch (m_af) {
-		case AF_INET:
-			LogError("Error returned from poll on IPv4 UDP socket on port %u, err: %lu", m_localPort, ::GetLastError());
-			break;
-		case AF_INET6:
-			LogError("Error returned from poll on IPv6 UDP socket on port %u, err: %lu", m_localPort, ::GetLastError());
-			break;
-		default:
-			LogError("Error returned from poll on unknown protocol (%d) UDP socket on port %u, err: %lu", m_af, m_localPort, ::GetLastError());
-			break;
-		}
-#else
-		switch (m_af) {
-		case AF_INET:
-			LogError("Error returned from poll on IPv4 UDP socket on port %u, err: %d", m_localPort, errno);
-			break;
-		case AF_INET6:
-			LogError("Error returned from poll on IPv6 UDP socket on port %u, err: %d", m_localPort, errno);
-			break;
-		default:
-			LogError("Error returned from poll on unknown protocol (%d) UDP socket on port %u, err: %d", m_af, m_localPort, errno);
-			break;
-		}
-#endif
-		return -1;
-	}
-
-	if ((pfd.revents & POLLIN) == 0)
-		return 0;
-
 #if defined(_WIN32) || defined(_WIN64)
 	int size = sizeof(sockaddr_storage);
 #else
 	socklen_t size = sizeof(sockaddr_storage);
 #endif
 
+	// A single non-blocking receive, no data is reported as EAGAIN rather than an error
 #if defined(_WIN32) || defined(_WIN64)
 	int len = ::recvfrom(m_fd, (char*)buffer, length, 0, (sockaddr *)&address, &size);
+	if ((len < 0) && (::WSAGetLastError() == WSAEWOULDBLOCK))
+		return 0;
 #else
-	ssize_t len = ::recvfrom(m_fd, (char*)buffer, length, 0, (sockaddr *)&address, &size);
+	ssize_t len = ::recvfrom(m_fd, (char*)buffer, length, MSG_DONTWAIT, (sockaddr *)&address, &size);
+	if ((len < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+		return 0;
 #endif
 	if (len <= 0) {
 #if defined(_WIN32) || defined(_WIN64)
@@ -470,6 +502,139 @@ bool CUDPSocket::write(const unsigned char* buffer, unsigned int length, const s
 	return result;
 }
 
+int CUDPSocket::read(CUDPDatagram* datagrams, unsigned int count)
+{
+	assert(datagrams != nullptr);
+	assert((count > 0U) && (count <= UDP_BATCH_LENGTH));
+
+#if defined(_WIN32) || defined(_WIN64)
+	// No recvmmsg() on Windows, fall back to one recvfrom() per datagram
+	unsigned int n = 0U;
+	while (n < count) {
+		int len = read(datagrams[n].m_data, UDP_DATAGRAM_LENGTH, datagrams[n].m_addr, datagrams[n].m_addrLen);
+		if (len < 0)
+			return (n > 0U) ? int(n) : -1;
+		if (len == 0)
+			break;
+
+		datagrams[n].m_length = len;
+		n++;
+	}
+
+	return int(n);
+#else
+	if (m_fd == -1)
+		return 0;
+
+	struct mmsghdr msgs[UDP_BATCH_LENGTH];
+	struct iovec   iovs[UDP_BATCH_LENGTH];
+
+	::memset(msgs, 0x00U, count * sizeof(struct mmsghdr));
+
+	for (unsigned int i = 0U; i < count; i++) {
+		iovs[i].iov_base = datagrams[i].m_data;
+		iovs[i].iov_len  = UDP_DATAGRAM_LENGTH;
+
+		msgs[i].msg_hdr.msg_name    = &datagrams[i].m_addr;
+		msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+		msgs[i].msg_hdr.msg_iov     = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen  = 1U;
+	}
+
+	int ret = ::recvmmsg(m_fd, msgs, count, MSG_DONTWAIT, nullptr);
+	if (ret < 0) {
+		if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+			return 0;
+
+		switch (m_af) {
+		case AF_INET:
+			LogError("Error returned from recvmmsg on IPv4 UDP socket on port %u, err: %d", m_localPort, errno);
+			break;
+		case AF_INET6:
+			LogError("Error returned from recvmmsg on IPv6 UDP socket on port %u, err: %d", m_localPort, errno);
+			break;
+		default:
+			LogError("Error returned from recvmmsg on unknown protocol (%d) UDP socket on port %u, err: %d", m_af, m_localPort, errno);
+			break;
+		}
+
+		if (errno == ENOTSOCK) {
+			LogMessage("Re-opening UDP port");
+			close();
+			open();
+		}
+
+		return -1;
+	}
+
+	for (int i = 0; i < ret; i++) {
+		datagrams[i].m_length  = msgs[i].msg_len;
+		datagrams[i].m_addrLen = msgs[i].msg_hdr.msg_namelen;
+	}
+
+	return ret;
+#endif
+}
+
+int CUDPSocket::write(const CUDPDatagram* datagrams, unsigned int count)
+{
+	assert(datagrams != nullptr);
+	assert((count > 0U) && (count <= UDP_BATCH_LENGTH));
+
+#if defined(_WIN32) || defined(_WIN64)
+	// No sendmmsg() on Windows, fall back to one sendto() per datagram
+	for (unsigned int i = 0U; i < count; i++) {
+		bool ret = write(datagrams[i].m_data, datagrams[i].m_length, datagrams[i].m_addr, datagrams[i].m_addrLen);
+		if (!ret)
+			return (i > 0U) ? int(i) : -1;
+	}
+
+	return int(count);
+#else
+	assert(m_fd >= 0);
+
+	struct mmsghdr msgs[UDP_BATCH_LENGTH];
+	struct iovec   iovs[UDP_BATCH_LENGTH];
+
+	::memset(msgs, 0x00U, count * sizeof(struct mmsghdr));
+
+	for (unsigned int i = 0U; i < count; i++) {
+		iovs[i].iov_base = (void*)datagrams[i].m_data;
+		iovs[i].iov_len  = datagrams[i].m_length;
+
+		msgs[i].msg_hdr.msg_name    = (void*)&datagrams[i].m_addr;
+		msgs[i].msg_hdr.msg_namelen = datagrams[i].m_addrLen;
+		msgs[i].msg_hdr.msg_iov     = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen  = 1U;
+	}
+
+	// sendmmsg() may stop early, carry on from where it got to
+	unsigned int sent = 0U;
+	while (sent < count) {
+		int ret = ::sendmmsg(m_fd, msgs + sent, count - sent, 0);
+		if (ret < 0) {
+			switch (m_af) {
+			case AF_INET:
+				LogError("Error returned from sendmmsg on IPv4 UDP socket on port %u, err: %d", m_localPort, errno);
+				break;
+			case AF_INET6:
+				LogError("Error returned from sendmmsg on IPv6 UDP socket on port %u, err: %d", m_localPort, errno);
+				break;
+			default:
+				LogError("Error returned from sendmmsg on unknown protocol (%d) UDP socket on port %u, err: %d", m_af, m_localPort, errno);
+				break;
+			}
+
+			return (sent > 0U) ? int(sent) : -1;
+		}
+
+		sent += ret;
+	}
+
+	return int(sent);
+#endif
+}
+
 void CUDPSocket::close()
 {
 #if defined(_WIN32) || defined(_WIN64)
@@ -484,3 +649,17 @@ void CUDPSocket::close()
 	}
 #endif
 }
+
+#if defined(_WIN32) || defined(_WIN64)
+SOCKET CUDPSocket::getFd() const
+#else
+int CUDPSocket::getFd() const
+#endif
+{
+	return m_fd;
+}
+
+unsigned int CUDPSocket::getGeneration() const
+{
+	return m_generation;
+}
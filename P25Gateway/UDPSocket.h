@@ -1,5 +1,5 @@
 /*
- *   Copyright (C) 2009-2011,2013,2015,2016,2020,2024,2025 by Jonathan Naylor G4KLX
+ *   Copyright (C) 2009-2011,2013,2015,2016,2020,2024,2025,2026 by Jonathan Naylor G4KLX
  *
  *   This program is free software; you can redistribute it and/or modify
  *   it under the terms of the GNU General Public License as published by
@@ -40,6 +40,16 @@ enum class IPMATCHTYPE {
 	ADDRESS_ONLY
 };
 
+const unsigned int UDP_DATAGRAM_LENGTH = 200U;
+const unsigned int UDP_BATCH_LENGTH    = 16U;
+
+struct CUDPDatagram {
+	unsigned char    m_data[UDP_DATAGRAM_LENGTH];
+	unsigned int     m_length;
+	sockaddr_storage m_addr;
+	unsigned int     m_addrLen;
+};
+
 class CUDPSocket {
 public:
 	CUDPSocket(const std::string& address, unsigned short port = 0U);
@@ -47,13 +57,27 @@ public:
 	~CUDPSocket();
 
 	bool open();
-	bool open(const sockaddr_storage& address);
+	bool open(const sockaddr_storage& address, bool dualStack = false);
 
 	int  read(unsigned char* buffer, unsigned int length, sockaddr_storage& address, unsigned int &addressLength);
 	bool write(const unsigned char* buffer, unsigned int length, const sockaddr_storage& address, unsigned int addressLength);
 
+	// Batched versions, at most UDP_BATCH_LENGTH datagrams are handled per call
+	int  read(CUDPDatagram* datagrams, unsigned int count);
+	int  write(const CUDPDatagram* datagrams, unsigned int count);
+
 	void close();
 
+#if defined(_WIN32) || defined(_WIN64)
+	SOCKET getFd() const;
+#else
+	int    getFd() const;
+#endif
+
+	// Changes every time the socket is opened, so that a re-opened socket
+	// can be told apart even when it is given the same fd as before
+	unsigned int getGeneration() const;
+
 	static void startup();
 	static void shutdown();
 
@@ -62,9 +86,13 @@ public:
 
 	static bool match(const sockaddr_storage& addr1, const sockaddr_storage& addr2, IPMATCHTYPE type = IPMATCHTYPE::ADDRESS_AND_PORT);
 
+	static void mapIPv4(const sockaddr_storage& addr4, sockaddr_storage& addr6, unsigned int& addrLen6);
+
 private:
 	std::string    m_localAddress;
 	unsigned short m_localPort;
+	bool           m_dualStack;
+	unsigned int   m_generation;
 #if defined(_WIN32) || defined(_WIN64)
 	SOCKET         m_fd;
 	int            m_af;
@@ -72,6 +100,8 @@ private:
 	int            m_fd;
 	sa_family_t    m_af;
 #endif
+
+	static bool matchMapped(const sockaddr_storage& addr6, const sockaddr_storage& addr4, IPMATCHTYPE type);
 };
 
 #endif
@@ -1,5 +1,5 @@
 /*
-*   Copyright (C) 2017,2018,2019,2024,2025 by Jonathan Naylor G4KLX
+*   Copyright (C) 2017,2018,2019,2024,2025,2026 by Jonathan Naylor G4KLX
 *
 *   This program is free software; you can redistribute it and/or modify
 *   it under the terms of the GNU General Public License as published by
@@ -24,8 +24,6 @@
 #include <cstdlib>
 #include <cassert>
 
-#include <sys/stat.h>
-
 const unsigned char REC62[] = {
     0x62U, 0x02U, 0x02U, 0x0CU, 0x0BU, 0x12U, 0x64U, 0x00U, 0x00U, 0x80U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U, 0x00U,
     0x00U, 0x00U, 0x00U, 0x00U, 0x00U };
@@ -89,324 +87,303 @@ const unsigned char SILENCE[] = { 0x04U, 0x0CU, 0xFDU, 0x7BU, 0xFBU, 0x7DU, 0xF2
 
 const unsigned int P25_FRAME_TIME = 20U;
 
+struct CVoiceRecord {
+	const unsigned char* m_template;
+	unsigned int         m_length;
+	unsigned int         m_offset;
+};
+
+// The records of the two LDUs in order, with where the IMBE data goes in each
+const CVoiceRecord VOICE_RECORDS[] = {
+	{REC62, 22U, 10U}, {REC63, 14U, 1U}, {REC64, 17U, 5U}, {REC65, 17U, 5U}, {REC66, 17U, 5U}, {REC67, 17U, 5U},
+	{REC68, 17U, 5U},  {REC69, 17U, 5U}, {REC6A, 16U, 4U}, {REC6B, 22U, 10U}, {REC6C, 14U, 1U}, {REC6D, 17U, 5U},
+	{REC6E, 17U, 5U},  {REC6F, 17U, 5U}, {REC70, 17U, 5U}, {REC71, 17U, 5U}, {REC72, 17U, 5U}, {REC73, 16U, 4U}};
+
+const unsigned int VOICE_RECORD_COUNT = sizeof(VOICE_RECORDS) / sizeof(CVoiceRecord);
+
 const unsigned int SILENCE_LENGTH = 4U;
 const unsigned int IMBE_LENGTH = 11U;
 
 const unsigned int LDU_LENGTH = 9U;
 
+// Rendered announcements kept, not counting the pre-rendered ones
+const unsigned int VOICE_CACHE_SIZE = 50U;
+
 CVoice::CVoice(const std::string& directory, const std::string& language, unsigned int srcId) :
-m_language(language),
-m_indxFile(),
-m_imbeFile(),
+m_directory(directory),
+m_packs(),
+m_languages(),
 m_srcId(srcId),
 m_status(VOICE_STATUS::NONE),
 m_timer(1000U, 1U),
-m_stopWatch(),
+m_clock(P25_FRAME_TIME),
+m_announcement(nullptr),
 m_sent(0U),
-m_n(0x62U),
-m_dstId(0U),
-m_imbe(nullptr),
-m_voiceData(nullptr),
-m_voiceLength(0U),
-m_positions()
+m_segment(0U),
+m_segmentFrame(0U),
+m_records(),
+m_cache(),
+m_cacheIndex()
 {
 	assert(!directory.empty());
 	assert(!language.empty());
 
-#if defined(_WIN32) || defined(_WIN64)
-	m_indxFile = directory + "\\" + language + ".indx";
-	m_imbeFile = directory + "\\" + language + ".imbe";
-#else
-	m_indxFile = directory + "/" + language + ".indx";
-	m_imbeFile = directory + "/" + language + ".imbe";
-#endif
-
-	// Approximately 10 seconds worth
-	m_voiceData = new unsigned char[10U * 50U * IMBE_LENGTH];
+	// The first pack is the default language
+	m_packs.push_back(new CVoicePack(directory, language));
 }
 
 CVoice::~CVoice()
 {
-	for (std::unordered_map<std::string, CPositions*>::iterator it = m_positions.begin(); it != m_positions.end(); ++it)
-		delete it->second;
-
-	m_positions.clear();
-
-	delete[] m_imbe;
-	delete[] m_voiceData;
+	for (auto& pack : m_packs)
+		delete pack;
 }
 
 bool CVoice::open()
 {
-	FILE* fpindx = ::fopen(m_indxFile.c_str(), "rt");
-	if (fpindx == nullptr) {
-		LogError("Unable to open the index file - %s", m_indxFile.c_str());
+	if (!m_packs.front()->open())
 		return false;
+
+	find(VOICE_PHRASE::NOT_LINKED, 9999U, true);
+
+	return true;
+}
+
+bool CVoice::setLanguage(unsigned int tg, const std::string& language)
+{
+	CVoicePack* pack = nullptr;
+	for (const auto& it : m_packs) {
+		if (it->getLanguage() == language) {
+			pack = it;
+			break;
+		}
 	}
 
-	struct stat statStruct;
-	int ret = ::stat(m_imbeFile.c_str(), &statStruct);
-	if (ret != 0) {
-		LogError("Unable to stat the IMBE file - %s", m_imbeFile.c_str());
-		::fclose(fpindx);
-		return false;
+	// Each language is only loaded once, however many talk groups use it
+	if (pack == nullptr) {
+		pack = new CVoicePack(m_directory, language);
+		if (!pack->open()) {
+			LogWarning("Using %s for talk group %u", m_packs.front()->getLanguage().c_str(), tg);
+			delete pack;
+			return false;
+		}
+
+		m_packs.push_back(pack);
 	}
 
-	FILE* fpimbe = ::fopen(m_imbeFile.c_str(), "rb");
-	if (fpimbe == nullptr) {
-		LogError("Unable to open the IMBE file - %s", m_imbeFile.c_str());
-		::fclose(fpindx);
-		return false;
+	m_languages[tg] = pack;
+
+	// Drop anything already rendered in the old language
+	std::unordered_map<uint64_t, std::list<CAnnouncement>::iterator>::iterator it = m_cacheIndex.find((uint64_t(VOICE_PHRASE::LINKED_TO) << 32) | tg);
+	if ((it != m_cacheIndex.end()) && (&(*it->second) != m_announcement)) {
+		m_cache.erase(it->second);
+		m_cacheIndex.erase(it);
 	}
 
-	m_imbe = new unsigned char[statStruct.st_size];
+	return true;
+}
+
+void CVoice::linkedTo(unsigned int tg)
+{
+	createVoice(find(VOICE_PHRASE::LINKED_TO, tg, false));
+}
+
+void CVoice::unlinked()
+{
+	createVoice(find(VOICE_PHRASE::NOT_LINKED, 9999U, false));
+}
 
-	size_t sizeRead = ::fread(m_imbe, 1U, statStruct.st_size, fpimbe);
-	if (sizeRead != 0U) {
-		char buffer[80U];
-		while (::fgets(buffer, 80, fpindx) != nullptr) {
-			char* p1 = ::strtok(buffer, "\t\r\n");
-			char* p2 = ::strtok(nullptr, "\t\r\n");
-			char* p3 = ::strtok(nullptr, "\t\r\n");
+void CVoice::prerender(unsigned int tg)
+{
+	find(VOICE_PHRASE::LINKED_TO, tg, true);
+}
 
-			if (p1 != nullptr && p2 != nullptr && p3 != nullptr) {
-				std::string symbol  = std::string(p1);
-				unsigned int start  = ::atoi(p2) * IMBE_LENGTH;
-				unsigned int length = ::atoi(p3) * IMBE_LENGTH;
+const CAnnouncement& CVoice::find(VOICE_PHRASE phrase, unsigned int tg, bool pin)
+{
+	uint64_t key = (uint64_t(phrase) << 32) | tg;
+
+	std::unordered_map<uint64_t, std::list<CAnnouncement>::iterator>::iterator it = m_cacheIndex.find(key);
+	if (it != m_cacheIndex.end()) {
+		m_cache.splice(m_cache.begin(), m_cache, it->second);
+		it->second->m_pinned = it->second->m_pinned || pin;
+		return *it->second;
+	}
 
-				CPositions* pos = new CPositions;
-				pos->m_start = start;
-				pos->m_length = length;
+	// Drop the least recently used announcement, but never the one being sent
+	unsigned int count = 0U;
+	for (const auto& announcement : m_cache) {
+		if (!announcement.m_pinned)
+			count++;
+	}
 
-				m_positions[symbol] = pos;
+	if (!pin && (count >= VOICE_CACHE_SIZE)) {
+		for (std::list<CAnnouncement>::iterator rit = m_cache.end(); rit != m_cache.begin();) {
+			--rit;
+			if (!rit->m_pinned && (&(*rit) != m_announcement)) {
+				m_cacheIndex.erase(rit->m_key);
+				m_cache.erase(rit);
+				break;
 			}
 		}
 	}
 
-	::fclose(fpindx);
-	::fclose(fpimbe);
+	m_cache.emplace_front();
 
-	LogInfo("Loaded the audio and index file for %s", m_language.c_str());
+	CAnnouncement& announcement = m_cache.front();
+	announcement.m_key    = key;
+	announcement.m_pinned = pin;
+	render(phrase, tg, announcement);
 
-	return true;
+	m_cacheIndex[key] = m_cache.begin();
+
+	return announcement;
 }
 
-void CVoice::linkedTo(unsigned int tg)
+void CVoice::render(VOICE_PHRASE phrase, unsigned int tg, CAnnouncement& announcement) const
 {
-	char letters[10U];
-	::sprintf(letters, "%u", tg);
+	const CVoicePack& pack = getPack(tg);
 
 	std::vector<std::string> words;
-	if (m_positions.count("linkedto") == 0U) {
-		words.push_back("linked");
-		words.push_back("2");
-	} else {
-		words.push_back("linkedto");
-	}
 
-	for (unsigned int i = 0U; (i < 10U) && (letters[i] != 0x00U); i++)
-		words.push_back(std::string(1U, letters[i]));
+	if (phrase == VOICE_PHRASE::LINKED_TO) {
+		char letters[10U];
+		::sprintf(letters, "%u", tg);
 
-	createVoice(tg, words);
-}
+		if (!pack.has("linkedto")) {
+			words.push_back("linked");
+			words.push_back("2");
+		} else {
+			words.push_back("linkedto");
+		}
 
-void CVoice::unlinked()
-{
-	std::vector<std::string> words;
-	words.push_back("notlinked");
+		for (unsigned int i = 0U; (i < 10U) && (letters[i] != 0x00U); i++)
+			words.push_back(std::string(1U, letters[i]));
+	} else {
+		words.push_back("notlinked");
+	}
 
-	createVoice(9999U, words);
-}
+	announcement.m_dstId  = tg;
+	announcement.m_frames = 0U;
+	announcement.m_segments.clear();
 
-void CVoice::createVoice(unsigned int tg, const std::vector<std::string>& words)
-{
-	m_dstId = tg;
+	// Silence before the voice
+	announcement.m_segments.push_back({nullptr, SILENCE_LENGTH});
+	announcement.m_frames += SILENCE_LENGTH;
 
-	m_voiceLength = 0U;
 	for (std::vector<std::string>::const_iterator it = words.begin(); it != words.end(); ++it) {
-		if (m_positions.count(*it) > 0U) {
-			CPositions* position = m_positions.at(*it);
-			m_voiceLength += position->m_length;
-		} else {
+		unsigned int length = 0U;
+		const unsigned char* imbe = pack.find(it->c_str(), length);
+		if (imbe == nullptr) {
 			LogWarning("Unable to find character/phrase \"%s\" in the index", (*it).c_str());
+			continue;
 		}
-	}
 
-	// Add space for silence before and after the voice
-	m_voiceLength += SILENCE_LENGTH * IMBE_LENGTH;
-	m_voiceLength += SILENCE_LENGTH * IMBE_LENGTH;
+		unsigned int frames = length / IMBE_LENGTH;
+		if (frames > 0U) {
+			announcement.m_segments.push_back({imbe, frames});
+			announcement.m_frames += frames;
+		}
+	}
 
-	// Round to the next highest LDU frame length
-	unsigned int n = (m_voiceLength / IMBE_LENGTH) % LDU_LENGTH;
+	// Silence after the voice, rounded up to the next highest LDU frame length
+	unsigned int silence = SILENCE_LENGTH;
+	unsigned int n = (announcement.m_frames + silence) % LDU_LENGTH;
 	if (n > 0U)
-		m_voiceLength += (LDU_LENGTH - n) * IMBE_LENGTH;
+		silence += LDU_LENGTH - n;
 
-	// Fill the IMBE data with silence
-	unsigned int offset = 0U;
-	for (unsigned int i = 0U; i < (m_voiceLength / IMBE_LENGTH); i++, offset += IMBE_LENGTH)
-		::memcpy(m_voiceData + offset, SILENCE, IMBE_LENGTH);
+	announcement.m_segments.push_back({nullptr, silence});
+	announcement.m_frames += silence;
+}
 
-	// Put offset in for silence at the beginning
-	unsigned int pos = SILENCE_LENGTH * IMBE_LENGTH;
-	for (std::vector<std::string>::const_iterator it = words.begin(); it != words.end(); ++it) {
-		if (m_positions.count(*it) > 0U) {
-			CPositions* position = m_positions.at(*it);
-			unsigned int start  = position->m_start;
-			unsigned int length = position->m_length;
-			::memcpy(m_voiceData + pos, m_imbe + start, length);
-			pos += length;
+const CVoicePack& CVoice::getPack(unsigned int tg) const
+{
+	std::unordered_map<unsigned int, CVoicePack*>::const_iterator it = m_languages.find(tg);
+	if (it != m_languages.cend())
+		return *it->second;
+
+	return *m_packs.front();
+}
+
+void CVoice::createVoice(const CAnnouncement& announcement)
+{
+	m_announcement = &announcement;
+
+	// Patch the ids into the records once, rather than on every frame
+	for (unsigned int i = 0U; i < VOICE_RECORD_COUNT; i++) {
+		unsigned char* buffer = m_records[i];
+		::memcpy(buffer, VOICE_RECORDS[i].m_template, VOICE_RECORDS[i].m_length);
+
+		if (buffer[0U] == 0x65U) {
+			buffer[1U] = (announcement.m_dstId >> 16) & 0xFFU;
+			buffer[2U] = (announcement.m_dstId >> 8) & 0xFFU;
+			buffer[3U] = (announcement.m_dstId >> 0) & 0xFFU;
+		} else if (buffer[0U] == 0x66U) {
+			buffer[1U] = (m_srcId >> 16) & 0xFFU;
+			buffer[2U] = (m_srcId >> 8) & 0xFFU;
+			buffer[3U] = (m_srcId >> 0) & 0xFFU;
 		}
 	}
+
+	// An announcement replaced while it is being sent carries on from the same frame
+	m_segment      = 0U;
+	m_segmentFrame = m_sent;
+	while ((m_segment < announcement.m_segments.size()) && (m_segmentFrame >= announcement.m_segments[m_segment].m_frames)) {
+		m_segmentFrame -= announcement.m_segments[m_segment].m_frames;
+		m_segment++;
+	}
 }
 
-unsigned int CVoice::read(unsigned char* data)
+unsigned int CVoice::read(const unsigned char*& data)
 {
-	assert(data != nullptr);
-
 	if (m_status != VOICE_STATUS::SENDING)
 		return 0U;
 
-	unsigned int offset = m_sent * IMBE_LENGTH;
+	assert(m_announcement != nullptr);
 
-	if (offset >= m_voiceLength) {
-		::memcpy(data, REC80, 17U);
+	if (m_sent >= m_announcement->m_frames) {
+		data = REC80;
 		m_timer.stop();
-		m_voiceLength = 0U;
+		m_clock.stop();
+		m_announcement = nullptr;
 		m_status = VOICE_STATUS::NONE;
+
+		LogDebug("Sent a voice announcement of %u frames, jitter mean %u us, max %u us", m_clock.getFrames(), m_clock.getMeanJitter(), m_clock.getMaxJitter());
+
 		return 17U;
 	}
 
-	unsigned int count = m_stopWatch.elapsed() / P25_FRAME_TIME;
+	if (!m_clock.isDue())
+		return 0U;
 
-	unsigned int length = 0U;
+	// The records were patched when the announcement was queued, only the IMBE changes per frame
+	unsigned int n = m_sent % VOICE_RECORD_COUNT;
+	const CVoiceRecord& record = VOICE_RECORDS[n];
+	const CVoiceSegment& segment = m_announcement->m_segments[m_segment];
 
-	if (m_sent < count) {
-		switch (m_n) {
-		case 0x62U:
-			::memcpy(data, REC62, 22U);
-			::memcpy(data + 10U, m_voiceData + offset, IMBE_LENGTH);
-			length = 22U;
-			m_n = 0x63U;
-			break;
-		case 0x63U:
-			::memcpy(data, REC63, 14U);
-			::memcpy(data + 1U, m_voiceData + offset, IMBE_LENGTH);
-			length = 14U;
-			m_n = 0x64U;
-			break;
-		case 0x64U:
-			::memcpy(data, REC64, 17U);
-			::memcpy(data + 5U, m_voiceData + offset, IMBE_LENGTH);
-			length = 17U;
-			m_n = 0x65U;
-			break;
-		case 0x65U:
-			::memcpy(data, REC65, 17U);
-			data[1U] = (m_dstId >> 16) & 0xFFU;
-			data[2U] = (m_dstId >> 8) & 0xFFU;
-			data[3U] = (m_dstId >> 0) & 0xFFU;
-			::memcpy(data + 5U, m_voiceData + offset, IMBE_LENGTH);
-			length = 17U;
-			m_n = 0x66U;
-			break;
-		case 0x66U:
-			::memcpy(data, REC66, 17U);
-			data[1U] = (m_srcId >> 16) & 0xFFU;
-			data[2U] = (m_srcId >> 8) & 0xFFU;
-			data[3U] = (m_srcId >> 0) & 0xFFU;
-			::memcpy(data + 5U, m_voiceData + offset, IMBE_LENGTH);
-			length = 17U;
-			m_n = 0x67U;
-			break;
-		case 0x67U:
-			::memcpy(data, REC67, 17U);
-			::memcpy(data + 5U, m_voiceData + offset, IMBE_LENGTH);
-			length = 17U;
-			m_n = 0x68U;
-			break;
-		case 0x68U:
-			::memcpy(data, REC68, 17U);
-			::memcpy(data + 5U, m_voiceData + offset, IMBE_LENGTH);
-			length = 17U;
-			m_n = 0x69U;
-			break;
-		case 0x69U:
-			::memcpy(data, REC69, 17U);
-			::memcpy(data + 5U, m_voiceData + offset, IMBE_LENGTH);
-			length = 17U;
-			m_n = 0x6AU;
-			break;
-		case 0x6AU:
-			::memcpy(data, REC6A, 16U);
-			::memcpy(data + 4U, m_voiceData + offset, IMBE_LENGTH);
-			length = 16U;
-			m_n = 0x6BU;
-			break;
-		case 0x6BU:
-			::memcpy(data, REC6B, 22U);
-			::memcpy(data + 10U, m_voiceData + offset, IMBE_LENGTH);
-			length = 22U;
-			m_n = 0x6CU;
-			break;
-		case 0x6CU:
-			::memcpy(data, REC6C, 14U);
-			::memcpy(data + 1U, m_voiceData + offset, IMBE_LENGTH);
-			length = 14U;
-			m_n = 0x6DU;
-			break;
-		case 0x6DU:
-			::memcpy(data, REC6D, 17U);
-			::memcpy(data + 5U, m_voiceData + offset, IMBE_LENGTH);
-			length = 17U;
-			m_n = 0x6EU;
-			break;
-		case 0x6EU:
-			::memcpy(data, REC6E, 17U);
-			::memcpy(data + 5U, m_voiceData + offset, IMBE_LENGTH);
-			length = 17U;
-			m_n = 0x6FU;
-			break;
-		case 0x6FU:
-			::memcpy(data, REC6F, 17U);
-			::memcpy(data + 5U, m_voiceData + offset, IMBE_LENGTH);
-			length = 17U;
-			m_n = 0x70U;
-			break;
-		case 0x70U:
-			::memcpy(data, REC70, 17U);
-			::memcpy(data + 5U, m_voiceData + offset, IMBE_LENGTH);
-			length = 17U;
-			m_n = 0x71U;
-			break;
-		case 0x71U:
-			::memcpy(data, REC71, 17U);
-			::memcpy(data + 5U, m_voiceData + offset, IMBE_LENGTH);
-			length = 17U;
-			m_n = 0x72U;
-			break;
-		case 0x72U:
-			::memcpy(data, REC72, 17U);
-			::memcpy(data + 5U, m_voiceData + offset, IMBE_LENGTH);
-			length = 17U;
-			m_n = 0x73U;
-			break;
-		default:
-			::memcpy(data, REC73, 16U);
-			::memcpy(data + 4U, m_voiceData + offset, IMBE_LENGTH);
-			length = 16U;
-			m_n = 0x62U;
-			break;
-		}
+	const unsigned char* imbe = SILENCE;
+	if (segment.m_imbe != nullptr)
+		imbe = segment.m_imbe + m_segmentFrame * IMBE_LENGTH;
 
-		m_sent++;
+	unsigned char* buffer = m_records[n];
+	::memcpy(buffer + record.m_offset, imbe, IMBE_LENGTH);
+
+	m_segmentFrame++;
+	if (m_segmentFrame >= segment.m_frames) {
+		m_segmentFrame = 0U;
+		m_segment++;
 	}
 
-	return length;
+	m_sent++;
+
+	m_clock.tick();
+
+	data = buffer;
+
+	return record.m_length;
 }
 
 void CVoice::eof()
 {
-	if (m_voiceLength == 0U)
+	if (m_announcement == nullptr)
 		return;
 
 	m_status = VOICE_STATUS::WAITING;
@@ -419,14 +396,48 @@ void CVoice::clock(unsigned int ms)
 	m_timer.clock(ms);
 	if (m_timer.isRunning() && m_timer.hasExpired()) {
 		if (m_status == VOICE_STATUS::WAITING) {
-			m_stopWatch.start();
+			m_clock.start();
 			m_status = VOICE_STATUS::SENDING;
 			m_sent = 0U;
-			m_n = 0x62U;
+			m_segment = 0U;
+			m_segmentFrame = 0U;
+		}
+	}
+}
+
+unsigned int CVoice::getRemainingMS()
+{
+	switch (m_status) {
+	case VOICE_STATUS::WAITING:
+		return m_timer.getRemainingMS();
+
+	case VOICE_STATUS::SENDING: {
+			// The end of the announcement is sent straight away
+			if (m_sent >= m_announcement->m_frames)
+				return 0U;
+
+			// Otherwise the next frame is due at the frame clock deadline, rounded up
+			uint64_t deadline = m_clock.getDeadline();
+			uint64_t now      = CFrameClock::now();
+			if (deadline <= now)
+				return 0U;
+
+			return (unsigned int)((deadline - now + 999999ULL) / 1000000ULL);
 		}
+
+	default:
+		return NO_TIMEOUT;
 	}
 }
 
+uint64_t CVoice::getDeadline() const
+{
+	if ((m_status != VOICE_STATUS::SENDING) || (m_sent >= m_announcement->m_frames))
+		return 0U;
+
+	return m_clock.getDeadline();
+}
+
 bool CVoice::isBusy() const
 {
 	return (m_status == VOICE_STATUS::WAITING) || (m_status == VOICE_STATUS::SENDING);
@@ -1,5 +1,5 @@
 /*
-*   Copyright (C) 2017,2018,2019,2024,2025 by Jonathan Naylor G4KLX
+*   Copyright (C) 2017,2018,2019,2024,2025,2026 by Jonathan Naylor G4KLX
 *
 *   This program is free software; you can redistribute it and/or modify
 *   it under the terms of the GNU General Public License as published by
@@ -19,12 +19,15 @@
 #if !defined(Voice_H)
 #define	Voice_H
 
-#include "StopWatch.h"
+#include "VoicePack.h"
+#include "FrameClock.h"
 #include "Timer.h"
 
+#include <unordered_map>
+#include <cstdint>
 #include <string>
 #include <vector>
-#include <unordered_map>
+#include <list>
 
 enum class VOICE_STATUS {
 	NONE,
@@ -32,9 +35,25 @@ enum class VOICE_STATUS {
 	SENDING
 };
 
-struct CPositions {
-	unsigned int m_start;
-	unsigned int m_length;
+enum class VOICE_PHRASE {
+	LINKED_TO,
+	NOT_LINKED
+};
+
+// A run of frames from a voice pack, or of silence if m_imbe is nullptr
+struct CVoiceSegment {
+	const unsigned char* m_imbe;
+	unsigned int         m_frames;
+};
+
+// An announcement is only a list of segments, the records are built from
+// them one at a time as each is sent
+struct CAnnouncement {
+	uint64_t                   m_key;
+	bool                       m_pinned;
+	unsigned int               m_dstId;
+	unsigned int               m_frames;
+	std::vector<CVoiceSegment> m_segments;
 };
 
 class CVoice {
@@ -44,34 +63,49 @@ public:
 
 	bool open();
 
+	// Announces the talk group in a language other than the default
+	bool setLanguage(unsigned int tg, const std::string& language);
+
 	void linkedTo(unsigned int tg);
 	void unlinked();
 
-	unsigned int read(unsigned char* data);
+	// Renders the announcement for the talk group now and keeps it for good
+	void prerender(unsigned int tg);
+
+	// Points data at the next network record when one is due, and returns its length
+	unsigned int read(const unsigned char*& data);
 
 	void eof();
 
 	void clock(unsigned int ms);
 
+	unsigned int getRemainingMS();
+
+	// When the next frame is due on the CFrameClock clock, or zero
+	uint64_t getDeadline() const;
+
 	bool isBusy() const;
 
 private:
-	std::string                            m_language;
-	std::string                            m_indxFile;
-	std::string                            m_imbeFile;
+	std::string                            m_directory;
+	std::vector<CVoicePack*>               m_packs;
+	std::unordered_map<unsigned int, CVoicePack*> m_languages;
 	unsigned int                           m_srcId;
 	VOICE_STATUS                           m_status;
 	CTimer                                 m_timer;
-	CStopWatch                             m_stopWatch;
+	CFrameClock                            m_clock;
+	const CAnnouncement*                   m_announcement;
 	unsigned int                           m_sent;
-	unsigned int                           m_n;
-	unsigned int                           m_dstId;
-	unsigned char*                         m_imbe;
-	unsigned char*                         m_voiceData;
-	unsigned int                           m_voiceLength;
-	std::unordered_map<std::string, CPositions*> m_positions;
-
-	void createVoice(unsigned int tg, const std::vector<std::string>& words);
+	unsigned int                           m_segment;
+	unsigned int                           m_segmentFrame;
+	unsigned char                          m_records[18U][22U];
+	std::list<CAnnouncement>               m_cache;
+	std::unordered_map<uint64_t, std::list<CAnnouncement>::iterator> m_cacheIndex;
+
+	const CAnnouncement& find(VOICE_PHRASE phrase, unsigned int tg, bool pin);
+	const CVoicePack& getPack(unsigned int tg) const;
+	void render(VOICE_PHRASE phrase, unsigned int tg, CAnnouncement& announcement) const;
+	void createVoice(const CAnnouncement& announcement);
 };
 
 #endif
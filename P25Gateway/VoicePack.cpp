@@ -0,0 +1,229 @@
+/*
+ *   Copyright (C) 2026 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "VoicePack.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+const unsigned int IMBE_LENGTH = 11U;
+
+CVoicePack::CVoicePack(const std::string& directory, const std::string& language) :
+m_language(language),
+m_indxFile(),
+m_imbeFile(),
+m_symbols(),
+m_imbe(nullptr),
+m_imbeSize(0U)
+{
+	assert(!directory.empty());
+	assert(!language.empty());
+
+#if defined(_WIN32) || defined(_WIN64)
+	m_indxFile = directory + "\\" + language + ".indx";
+	m_imbeFile = directory + "\\" + language + ".imbe";
+#else
+	m_indxFile = directory + "/" + language + ".indx";
+	m_imbeFile = directory + "/" + language + ".imbe";
+#endif
+}
+
+CVoicePack::~CVoicePack()
+{
+	close();
+}
+
+bool CVoicePack::open()
+{
+	close();
+
+	FILE* fpindx = ::fopen(m_indxFile.c_str(), "rt");
+	if (fpindx == nullptr) {
+		LogError("Unable to open the index file - %s", m_indxFile.c_str());
+		return false;
+	}
+
+#if defined(_WIN32) || defined(_WIN64)
+	HANDLE file = ::CreateFileA(m_imbeFile.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		LogError("Unable to open the IMBE file - %s", m_imbeFile.c_str());
+		::fclose(fpindx);
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	HANDLE mapping = NULL;
+	if (::GetFileSizeEx(file, &fileSize) && (fileSize.QuadPart > 0))
+		mapping = ::CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	::CloseHandle(file);
+
+	void* map = NULL;
+	if (mapping != NULL) {
+		// The view keeps the mapping alive after its handle is closed
+		map = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		::CloseHandle(mapping);
+	}
+
+	if (map == NULL) {
+		LogError("Unable to map the IMBE file - %s", m_imbeFile.c_str());
+		::fclose(fpindx);
+		return false;
+	}
+
+	m_imbe     = (const unsigned char*)map;
+	m_imbeSize = size_t(fileSize.QuadPart);
+#else
+	int fd = ::open(m_imbeFile.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd == -1) {
+		LogError("Unable to open the IMBE file - %s", m_imbeFile.c_str());
+		::fclose(fpindx);
+		return false;
+	}
+
+	struct stat st;
+	if ((::fstat(fd, &st) != 0) || (st.st_size == 0)) {
+		LogError("Unable to stat the IMBE file - %s", m_imbeFile.c_str());
+		::close(fd);
+		::fclose(fpindx);
+		return false;
+	}
+
+	void* map = ::mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (map == MAP_FAILED) {
+		LogError("Unable to map the IMBE file - %s", m_imbeFile.c_str());
+		::fclose(fpindx);
+		return false;
+	}
+
+	m_imbe     = (const unsigned char*)map;
+	m_imbeSize = size_t(st.st_size);
+#endif
+
+	char buffer[80U];
+	while (::fgets(buffer, 80, fpindx) != nullptr) {
+		char* p1 = ::strtok(buffer, "\t\r\n");
+		char* p2 = ::strtok(nullptr, "\t\r\n");
+		char* p3 = ::strtok(nullptr, "\t\r\n");
+
+		if (p1 != nullptr && p2 != nullptr && p3 != nullptr) {
+			CVoiceSymbol symbol;
+			::memset(&symbol, 0x00U, sizeof(CVoiceSymbol));
+
+			if (::strlen(p1) >= VOICE_SYMBOL_LENGTH) {
+				LogWarning("The symbol \"%s\" in %s is too long", p1, m_indxFile.c_str());
+				continue;
+			}
+
+			::strcpy(symbol.m_symbol, p1);
+			symbol.m_start  = uint32_t(::atoi(p2)) * IMBE_LENGTH;
+			symbol.m_length = uint32_t(::atoi(p3)) * IMBE_LENGTH;
+
+			// Reading past the end of a mapping is fatal, so check every entry now
+			if ((uint64_t(symbol.m_start) + symbol.m_length) > m_imbeSize) {
+				LogWarning("The symbol \"%s\" is outside of %s", p1, m_imbeFile.c_str());
+				continue;
+			}
+
+			m_symbols.push_back(symbol);
+		}
+	}
+
+	::fclose(fpindx);
+
+	// A stable sort and keeping the last of any duplicates matches the old map
+	std::stable_sort(m_symbols.begin(), m_symbols.end(), [](const CVoiceSymbol& a, const CVoiceSymbol& b) { return ::strcmp(a.m_symbol, b.m_symbol) < 0; });
+
+	std::vector<CVoiceSymbol>::iterator out = m_symbols.begin();
+	for (std::vector<CVoiceSymbol>::const_iterator it = m_symbols.cbegin(); it != m_symbols.cend(); ++it) {
+		if ((out != m_symbols.begin()) && (::strcmp((out - 1)->m_symbol, it->m_symbol) == 0))
+			*(out - 1) = *it;
+		else
+			*out++ = *it;
+	}
+	m_symbols.erase(out, m_symbols.end());
+	m_symbols.shrink_to_fit();
+
+	LogInfo("Loaded the audio and index file for %s", m_language.c_str());
+
+	return true;
+}
+
+const unsigned char* CVoicePack::find(const char* symbol, unsigned int& length) const
+{
+	const CVoiceSymbol* entry = lookup(symbol);
+	if (entry == nullptr)
+		return nullptr;
+
+	length = entry->m_length;
+
+	return m_imbe + entry->m_start;
+}
+
+bool CVoicePack::has(const char* symbol) const
+{
+	return lookup(symbol) != nullptr;
+}
+
+const std::string& CVoicePack::getLanguage() const
+{
+	return m_language;
+}
+
+void CVoicePack::close()
+{
+	m_symbols.clear();
+
+	if (m_imbe == nullptr)
+		return;
+
+#if defined(_WIN32) || defined(_WIN64)
+	::UnmapViewOfFile(m_imbe);
+#else
+	::munmap((void*)m_imbe, m_imbeSize);
+#endif
+
+	m_imbe     = nullptr;
+	m_imbeSize = 0U;
+}
+
+const CVoicePack::CVoiceSymbol* CVoicePack::lookup(const char* symbol) const
+{
+	assert(symbol != nullptr);
+
+	std::vector<CVoiceSymbol>::const_iterator it = std::lower_bound(m_symbols.cbegin(), m_symbols.cend(), symbol, [](const CVoiceSymbol& entry, const char* symbol) { return ::strcmp(entry.m_symbol, symbol) < 0; });
+	if ((it == m_symbols.cend()) || (::strcmp(it->m_symbol, symbol) != 0))
+		return nullptr;
+
+	return &(*it);
+}
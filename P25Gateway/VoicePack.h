@@ -0,0 +1,66 @@
+/*
+ *   Copyright (C) 2026 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(VoicePack_H)
+#define	VoicePack_H
+
+#include <string>
+#include <vector>
+
+#include <cstdint>
+#include <cstddef>
+
+const unsigned int VOICE_SYMBOL_LENGTH = 16U;
+
+// One language of voice prompts. The .imbe file is mapped read only, so
+// that every process using the same language shares its pages, and the
+// .indx file is held as a flat array of symbols sorted by name.
+class CVoicePack {
+public:
+	CVoicePack(const std::string& directory, const std::string& language);
+	~CVoicePack();
+
+	bool open();
+
+	// Returns the IMBE data of the symbol, or nullptr if it is not in the index
+	const unsigned char* find(const char* symbol, unsigned int& length) const;
+
+	bool has(const char* symbol) const;
+
+	const std::string& getLanguage() const;
+
+	void close();
+
+private:
+	struct CVoiceSymbol {
+		char     m_symbol[VOICE_SYMBOL_LENGTH];
+		uint32_t m_start;
+		uint32_t m_length;
+	};
+
+	std::string               m_language;
+	std::string               m_indxFile;
+	std::string               m_imbeFile;
+	std::vector<CVoiceSymbol> m_symbols;
+	const unsigned char*      m_imbe;
+	size_t                    m_imbeSize;
+
+	const CVoiceSymbol* lookup(const char* symbol) const;
+};
+
+#endif
@@ -0,0 +1,45 @@
+/*
+ *   Copyright (C) 2026 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#ifndef	AddressKey_H
+#define	AddressKey_H
+
+#include "UDPSocket.h"
+
+#include <cstdint>
+#include <cstddef>
+
+// An address reduced to its family, address and port, with IPv4-mapped
+// IPv6 addresses turned back into plain IPv4
+struct CAddressKey {
+	CAddressKey();
+
+	static CAddressKey create(const sockaddr_storage& addr, unsigned int addrLen);
+
+	bool operator==(const CAddressKey& key) const;
+
+	uint16_t m_family;
+	uint16_t m_port;
+	uint8_t  m_addr[16U];
+};
+
+struct CAddressKeyHash {
+	size_t operator()(const CAddressKey& key) const;
+};
+
+#endif
@@ -0,0 +1,57 @@
+/*
+ *   Copyright (C) 2026 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "FramePool.h"
+
+#include <cassert>
+
+CFramePool::CFramePool(unsigned int budget) :
+m_free(),
+m_maxChunks(budget / sizeof(CFrameChunk)),
+m_chunks(0U)
+{
+}
+
+CFramePool::~CFramePool()
+{
+	for (auto& chunk : m_free)
+		delete chunk;
+}
+
+CFrameChunk* CFramePool::allocate()
+{
+	if (!m_free.empty()) {
+		CFrameChunk* chunk = m_free.back();
+		m_free.pop_back();
+		return chunk;
+	}
+
+	if (m_chunks >= m_maxChunks)
+		return nullptr;
+
+	m_chunks++;
+
+	return new CFrameChunk;
+}
+
+void CFramePool::release(CFrameChunk* chunk)
+{
+	assert(chunk != nullptr);
+
+	m_free.push_back(chunk);
+}
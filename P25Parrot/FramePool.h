@@ -0,0 +1,54 @@
+/*
+ *   Copyright (C) 2026 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(FramePool_H)
+#define	FramePool_H
+
+#include <vector>
+
+// The longest P25 network record
+const unsigned int FRAME_LENGTH = 22U;
+
+// One second of frames
+const unsigned int CHUNK_FRAMES = 50U;
+
+struct CFrameChunk {
+	unsigned char m_length[CHUNK_FRAMES];
+	unsigned char m_data[CHUNK_FRAMES][FRAME_LENGTH];
+};
+
+// A store of fixed size chunks of frames shared by all of the sessions, so
+// that memory is only used for what is actually being recorded. Chunks are
+// kept for reuse once returned, and no more than the budget are ever made.
+class CFramePool {
+public:
+	CFramePool(unsigned int budget);
+	~CFramePool();
+
+	// Returns nullptr once the budget has been used up
+	CFrameChunk* allocate();
+
+	void release(CFrameChunk* chunk);
+
+private:
+	std::vector<CFrameChunk*> m_free;
+	unsigned int              m_maxChunks;
+	unsigned int              m_chunks;
+};
+
+#endif
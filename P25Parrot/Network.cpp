@@ -1,5 +1,5 @@
 /*
- *   Copyright (C) 2009-2014,2016,2018,2020,2025 by Jonathan Naylor G4KLX
+ *   Copyright (C) 2009-2014,2016,2018,2020,2025,2026 by Jonathan Naylor G4KLX
  *
  *   This program is free software; you can redistribute it and/or modify
  *   it under the terms of the GNU General Public License as published by
@@ -24,11 +24,10 @@
 
 const unsigned int BUFFER_LENGTH = 200U;
 
-CNetwork::CNetwork(unsigned short port) :
-m_socket(port),
-m_addr(),
-m_addrLen(0U)
+CNetwork::CNetwork(unsigned short port, bool reusePort) :
+m_socket(port)
 {
+	m_socket.setReusePort(reusePort);
 }
 
 CNetwork::~CNetwork()
@@ -42,43 +41,31 @@ bool CNetwork::open()
 	return m_socket.open();
 }
 
-bool CNetwork::write(const unsigned char* data, unsigned int length)
+bool CNetwork::write(const unsigned char* data, unsigned int length, const sockaddr_storage& addr, unsigned int addrLen)
 {
-	if (m_addrLen == 0U)
-		return true;
-
 	assert(data != nullptr);
+	assert(addrLen > 0U);
 
-	return m_socket.write(data, length, m_addr, m_addrLen);
+	return m_socket.write(data, length, addr, addrLen);
 }
 
-unsigned int CNetwork::read(unsigned char* data)
+unsigned int CNetwork::read(unsigned char* data, sockaddr_storage& addr, unsigned int& addrLen)
 {
-	sockaddr_storage addr;
-	unsigned int addrlen;
-	int length = m_socket.read(data, BUFFER_LENGTH, addr, addrlen);
-	if (length <= 0)
-		return 0U;
-
-	m_addr    = addr;
-	m_addrLen = addrlen;
-
-	if (data[0U] == 0xF0U) {			// A poll
-		write(data, length);
-		return 0U;
-	} else if (data[0U] == 0xF1U) {	// An unlink
-		// Nothing to do
-		return 0U;
-	} else {
-		return length;
+	for (;;) {
+		int length = m_socket.read(data, BUFFER_LENGTH, addr, addrLen);
+		if (length <= 0)
+			return 0U;
+
+		if (data[0U] == 0xF0U) {			// A poll
+			write(data, length, addr, addrLen);
+		} else if (data[0U] == 0xF1U) {	// An unlink
+			// Nothing to do
+		} else {
+			return length;
+		}
 	}
 }
 
-void CNetwork::end()
-{
-	m_addrLen = 0U;
-}
-
 void CNetwork::close()
 {
 	m_socket.close();
@@ -1,5 +1,5 @@
 /*
- *   Copyright (C) 2009-2014,2016,2018,2020 by Jonathan Naylor G4KLX
+ *   Copyright (C) 2009-2014,2016,2018,2020,2026 by Jonathan Naylor G4KLX
  *
  *   This program is free software; you can redistribute it and/or modify
  *   it under the terms of the GNU General Public License as published by
@@ -26,23 +26,20 @@
 
 class CNetwork {
 public:
-	CNetwork(unsigned short port);
+	CNetwork(unsigned short port, bool reusePort);
 	~CNetwork();
 
 	bool open();
 
-	bool write(const unsigned char* data, unsigned int length);
+	bool write(const unsigned char* data, unsigned int length, const sockaddr_storage& addr, unsigned int addrLen);
 
-	unsigned int read(unsigned char* data);
-
-	void end();
+	// Answers any polls itself, and returns the next voice record and who sent it
+	unsigned int read(unsigned char* data, sockaddr_storage& addr, unsigned int& addrLen);
 
 	void close();
 
 private:
 	CUDPSocket       m_socket;
-	sockaddr_storage m_addr;
-	unsigned int     m_addrLen;
 };
 
 #endif
@@ -1,5 +1,5 @@
 /*
-*   Copyright (C) 2016,2018,2020,2024 by Jonathan Naylor G4KLX
+*   Copyright (C) 2016,2018,2020,2024,2026 by Jonathan Naylor G4KLX
 *
 *   This program is free software; you can redistribute it and/or modify
 *   it under the terms of the GNU General Public License as published by
@@ -16,21 +16,28 @@
 *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
 */
 
-#include "StopWatch.h"
+#include "ParrotWorker.h"
 #include "P25Parrot.h"
-#include "Parrot.h"
-#include "Network.h"
 #include "Version.h"
-#include "Thread.h"
-#include "Timer.h"
 #include "GitVersion.h"
 
+#include <vector>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 
+const unsigned int MAX_SESSIONS = 500U;
+
+// The most memory used for recordings by all of the sessions together
+const unsigned int PARROT_BUDGET = 64U * 1024U * 1024U;
+
+const unsigned int MAX_WORKERS = 64U;
+
 int main(int argc, char** argv)
 {
+	unsigned int workers = 1U;
+	std::string spill;
+
 	if (argc > 1) {
 		for (int currentArg = 1; currentArg < argc; ++currentArg) {
 			std::string arg = argv[currentArg];
@@ -38,18 +45,28 @@ int main(int argc, char** argv)
 				::fprintf(stdout, "P25Parrot version %s git #%.7s\n", VERSION, gitversion);
 				return 0;
 			}
+			else if (((arg == "-w") || (arg == "--workers")) && ((currentArg + 1) < argc)) {
+				workers = (unsigned int)::atoi(argv[++currentArg]);
+				if ((workers == 0U) || (workers > MAX_WORKERS)) {
+					::fprintf(stderr, "P25Parrot: invalid number of workers - %s\n", argv[currentArg]);
+					return 1;
+				}
+			}
+			else if (((arg == "-s") || (arg == "--spill")) && ((currentArg + 1) < argc)) {
+				spill = argv[++currentArg];
+			}
 			else if (arg.substr(0, 1) == "-") {
-				::fprintf(stderr, "Usage: P25Parrot [-v|--version] [-d|--debug] <port>\n");
+				::fprintf(stderr, "Usage: P25Parrot [-v|--version] [-d|--debug] [-w|--workers <n>] [-s|--spill <directory>] <port>\n");
 				return 1;
 			}
 			else {
-				unsigned short port = (unsigned short)::atoi(argv[1U]);
+				unsigned short port = (unsigned short)::atoi(arg.c_str());
 				if (port == 0U) {
-					::fprintf(stderr, "P25Parrot: invalid port number - %s\n", argv[1U]);
+					::fprintf(stderr, "P25Parrot: invalid port number - %s\n", arg.c_str());
 					return 1;
 				}
 
-				CP25Parrot parrot(port);
+				CP25Parrot parrot(port, workers, spill);
 				parrot.run();
 
 				return 0;
@@ -58,8 +75,10 @@ int main(int argc, char** argv)
 	}
 }
 
-CP25Parrot::CP25Parrot(unsigned short port) :
-m_port(port)
+CP25Parrot::CP25Parrot(unsigned short port, unsigned int workers, const std::string& spill) :
+m_port(port),
+m_workers(workers),
+m_spill(spill)
 {
 	CUDPSocket::startup();
 }
@@ -71,79 +90,43 @@ CP25Parrot::~CP25Parrot()
 
 void CP25Parrot::run()
 {
-	CParrot parrot(180U);
-	CNetwork network(m_port);
-
-	bool ret = network.open();
-	if (!ret)
-		return;
-
-	CStopWatch stopWatch;
-	stopWatch.start();
-
-	CTimer watchdogTimer(1000U, 0U, 1500U);
-	CTimer turnaroundTimer(1000U, 2U);
-
-	CStopWatch playoutTimer;
-	unsigned int count = 0U;
-	bool playing = false;
-
-	::fprintf(stdout, "Starting P25Parrot-%s\n", VERSION);
+#if defined(_WIN32) || defined(_WIN64)
+	// There is no SO_REUSEPORT to share out the clients between sockets
+	if (m_workers > 1U) {
+		::fprintf(stderr, "P25Parrot: multiple workers are not supported on Windows, using one\n");
+		m_workers = 1U;
+	}
+#endif
 
-	for (;;) {
-		unsigned char buffer[200U];
+	std::vector<CParrotWorker*> workers;
 
-		unsigned int len = network.read(buffer);
-		if (len > 0U) {
-			parrot.write(buffer, len);
-			watchdogTimer.start();
+	for (unsigned int i = 0U; i < m_workers; i++) {
+		CParrotWorker* worker = new CParrotWorker(m_port, m_workers > 1U, PARROT_BUDGET / m_workers, (MAX_SESSIONS + m_workers - 1U) / m_workers, m_spill);
+		workers.push_back(worker);
 
-			if (buffer[0U] == 0x80U) {
-				turnaroundTimer.start();
-				watchdogTimer.stop();
-				parrot.end();
-			}
-		}
-
-		if (turnaroundTimer.isRunning() && turnaroundTimer.hasExpired()) {
-			if (!playing) {
-				playoutTimer.start();
-				playing = true;
-				count = 0U;
-			}
-
-			// A frame every 20ms
-			unsigned int wanted = playoutTimer.elapsed() / 20U;
-			while (count < wanted) {
-				len = parrot.read(buffer);
-				if (len > 0U) {
-					network.write(buffer, len);
-					count++;
-				} else {
-					parrot.clear();
-					network.end();
-					turnaroundTimer.stop();
-					playing = false;
-					count = wanted;
-				}
-			}
+		bool ret = worker->open();
+		if (!ret) {
+			for (auto& it : workers)
+				delete it;
+			return;
 		}
+	}
 
-		unsigned int ms = stopWatch.elapsed();
-		stopWatch.start();
+	::fprintf(stdout, "Starting P25Parrot-%s with %u worker(s)\n", VERSION, m_workers);
 
-		watchdogTimer.clock(ms);
-		turnaroundTimer.clock(ms);
+	if (!m_spill.empty())
+		::fprintf(stdout, "Long recordings are spilled to %s\n", m_spill.c_str());
 
-		if (watchdogTimer.isRunning() && watchdogTimer.hasExpired()) {
-			turnaroundTimer.start();
-			watchdogTimer.stop();
-			parrot.end();
-		}
+	if (m_workers == 1U) {
+		workers.front()->entry();
+	} else {
+		for (auto& it : workers)
+			it->run();
 
-		if (ms < 5U)
-			CThread::sleep(5U);
+		for (auto& it : workers)
+			it->wait();
 	}
 
-	network.close();
+	for (auto& it : workers)
+		delete it;
 }
@@ -1,5 +1,5 @@
 /*
-*   Copyright (C) 2016,2018 by Jonathan Naylor G4KLX
+*   Copyright (C) 2016,2018,2026 by Jonathan Naylor G4KLX
 *
 *   This program is free software; you can redistribute it and/or modify
 *   it under the terms of the GNU General Public License as published by
@@ -19,16 +19,20 @@
 #if !defined(P25Parrot_H)
 #define	P25Parrot_H
 
+#include <string>
+
 class CP25Parrot
 {
 public:
-	CP25Parrot(unsigned short port);
+	CP25Parrot(unsigned short port, unsigned int workers, const std::string& spill);
 	~CP25Parrot();
 
 	void run();
 
 private:
 	unsigned short m_port;
+	unsigned int   m_workers;
+	std::string    m_spill;
 };
 
 #endif
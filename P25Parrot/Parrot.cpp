@@ -1,5 +1,5 @@
 /*
-*   Copyright (C) 2016,2025 by Jonathan Naylor G4KLX
+*   Copyright (C) 2016,2025,2026 by Jonathan Naylor G4KLX
 *
 *   This program is free software; you can redistribute it and/or modify
 *   it under the terms of the GNU General Public License as published by
@@ -22,32 +22,67 @@
 #include <cassert>
 #include <cstring>
 
-CParrot::CParrot(unsigned int timeout) :
-m_data(nullptr),
-m_length(timeout * 1000U + 1000U),
-m_used(0U),
-m_ptr(0U)
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// How much of a recording is kept in memory when spilling, in seconds
+const unsigned int SPILL_CHUNKS = 10U;
+
+const unsigned int NO_CHUNK = 0xFFFFFFFFU;
+
+CParrot::CParrot(CFramePool& pool, unsigned int timeout, const std::string& spill) :
+m_pool(pool),
+m_spill(spill),
+m_chunks(),
+m_maxFrames(timeout * 50U),
+m_frames(0U),
+m_ptr(0U),
+m_file(nullptr),
+m_spilled(0U),
+m_tail(nullptr),
+m_readAhead(nullptr),
+m_readAheadChunk(NO_CHUNK)
 {
 	assert(timeout > 0U);
-
-	m_data = new unsigned char[m_length];
 }
 
 CParrot::~CParrot()
 {
-	delete[] m_data;
+	clear();
 }
 
 bool CParrot::write(const unsigned char* data, unsigned int length)
 {
 	assert(data != nullptr);
 
-	if ((m_length - m_used) < (length + 2U))
+	if ((length == 0U) || (length > FRAME_LENGTH) || (m_frames >= m_maxFrames))
 		return false;
 
-	m_data[m_used] = length;
-	::memcpy(m_data + m_used + 1U, data, length);
-	m_used += length + 1U;
+	unsigned int n = m_frames % CHUNK_FRAMES;
+	if (n == 0U) {
+		if (m_file == nullptr) {
+			// Memory is only taken from the pool as the recording grows
+			CFrameChunk* chunk = nullptr;
+			if (m_spill.empty() || (m_chunks.size() < SPILL_CHUNKS))
+				chunk = m_pool.allocate();
+
+			if (chunk != nullptr)
+				m_chunks.push_back(chunk);
+			else if (m_spill.empty() || !openSpill())
+				return false;
+		} else {
+			// The last chunk is full, so move it out to the file
+			if (!writeTail())
+				return false;
+		}
+	}
+
+	CFrameChunk* chunk = (m_file != nullptr) ? m_tail : m_chunks.back();
+	chunk->m_length[n] = length;
+	::memcpy(chunk->m_data[n], data, length);
+	m_frames++;
 
 	return true;
 }
@@ -59,23 +94,122 @@ void CParrot::end()
 
 void CParrot::clear()
 {
-	m_used = 0U;
-	m_ptr = 0U;
+	for (auto& chunk : m_chunks)
+		m_pool.release(chunk);
+
+	if (m_file != nullptr) {
+		::fclose(m_file);
+		m_file = nullptr;
+	}
+
+	delete m_tail;
+	delete m_readAhead;
+
+	m_chunks.clear();
+	m_frames         = 0U;
+	m_ptr            = 0U;
+	m_spilled        = 0U;
+	m_tail           = nullptr;
+	m_readAhead      = nullptr;
+	m_readAheadChunk = NO_CHUNK;
 }
 
 unsigned int CParrot::read(unsigned char* data)
 {
 	assert(data != nullptr);
 
-	if (m_used == 0U)
+	if (m_ptr >= m_frames)
 		return 0U;
 
-	unsigned int length = m_data[m_ptr];
-	::memcpy(data, m_data + m_ptr + 1U, length);
-	m_ptr += length + 1U;
+	unsigned int c = m_ptr / CHUNK_FRAMES;
+	unsigned int n = m_ptr % CHUNK_FRAMES;
+
+	const CFrameChunk* chunk = nullptr;
+	if (c < m_chunks.size())
+		chunk = m_chunks[c];
+	else if ((c - m_chunks.size()) < m_spilled)
+		chunk = readSpill(c - m_chunks.size());
+	else
+		chunk = m_tail;
+
+	if (chunk == nullptr)
+		return 0U;
 
-	if (m_ptr >= m_used)
-		m_used = 0U;
+	unsigned int length = chunk->m_length[n];
+	::memcpy(data, chunk->m_data[n], length);
+	m_ptr++;
 
 	return length;
 }
+
+bool CParrot::openSpill()
+{
+#if defined(_WIN32) || defined(_WIN64)
+	m_file = ::tmpfile();
+	if (m_file == nullptr) {
+		::fprintf(stderr, "Unable to create a temporary file for the recording\n");
+		return false;
+	}
+#else
+	std::string name = m_spill + "/P25Parrot-XXXXXX";
+
+	int fd = ::mkstemp(&name[0U]);
+	if (fd < 0) {
+		::fprintf(stderr, "Unable to create a temporary file in %s\n", m_spill.c_str());
+		return false;
+	}
+
+	// Nothing is left behind on disk however the parrot stops
+	::unlink(name.c_str());
+
+	// Playback reads straight through the file
+	::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+	m_file = ::fdopen(fd, "w+b");
+	if (m_file == nullptr) {
+		::fprintf(stderr, "Unable to open the temporary file in %s\n", m_spill.c_str());
+		::close(fd);
+		return false;
+	}
+#endif
+
+	m_tail      = new CFrameChunk;
+	m_readAhead = new CFrameChunk;
+
+	return true;
+}
+
+bool CParrot::writeTail()
+{
+	assert(m_file != nullptr);
+	assert(m_tail != nullptr);
+
+	if ((::fseek(m_file, long(m_spilled * sizeof(CFrameChunk)), SEEK_SET) != 0) || (::fwrite(m_tail, sizeof(CFrameChunk), 1U, m_file) != 1U)) {
+		::fprintf(stderr, "Unable to write to the temporary file for the recording\n");
+		return false;
+	}
+
+	m_spilled++;
+
+	return true;
+}
+
+const CFrameChunk* CParrot::readSpill(unsigned int chunk)
+{
+	assert(m_file != nullptr);
+	assert(m_readAhead != nullptr);
+
+	// A whole second of frames is read at a time
+	if (chunk == m_readAheadChunk)
+		return m_readAhead;
+
+	if ((::fseek(m_file, long(chunk * sizeof(CFrameChunk)), SEEK_SET) != 0) || (::fread(m_readAhead, sizeof(CFrameChunk), 1U, m_file) != 1U)) {
+		::fprintf(stderr, "Unable to read from the temporary file for the recording\n");
+		m_readAheadChunk = NO_CHUNK;
+		return nullptr;
+	}
+
+	m_readAheadChunk = chunk;
+
+	return m_readAhead;
+}
@@ -1,5 +1,5 @@
 /*
-*   Copyright (C) 2016 by Jonathan Naylor G4KLX
+*   Copyright (C) 2016,2026 by Jonathan Naylor G4KLX
 *
 *   This program is free software; you can redistribute it and/or modify
 *   it under the terms of the GNU General Public License as published by
@@ -19,10 +19,18 @@
 #if !defined(Parrot_H)
 #define	Parrot_H
 
+#include "FramePool.h"
+
+#include <string>
+#include <vector>
+#include <cstdio>
+
 class CParrot
 {
 public:
-	CParrot(unsigned int timeout);
+	// With a spill directory only the start of a recording is held in memory,
+	// the rest is written out to a temporary file and read back for playback
+	CParrot(CFramePool& pool, unsigned int timeout, const std::string& spill);
 	~CParrot();
 
 	bool write(const unsigned char* data, unsigned int length);
@@ -34,10 +42,21 @@ public:
 	void clear();
 
 private:
-	unsigned char* m_data;
-	unsigned int   m_length;
-	unsigned int   m_used;
-	unsigned int   m_ptr;
+	CFramePool&               m_pool;
+	std::string               m_spill;
+	std::vector<CFrameChunk*> m_chunks;
+	unsigned int              m_maxFrames;
+	unsigned int              m_frames;
+	unsigned int              m_ptr;
+	FILE*                     m_file;
+	unsigned int              m_spilled;
+	CFrameChunk*              m_tail;
+	CFrameChunk*              m_readAhead;
+	unsigned int              m_readAheadChunk;
+
+	bool openSpill();
+	bool writeTail();
+	const CFrameChunk* readSpill(unsigned int chunk);
 };
 
 #endif
@@ -0,0 +1,105 @@
+/*
+ *   Copyright (C) 2026 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "ParrotWorker.h"
+#include "FrameClock.h"
+#include "StopWatch.h"
+
+#include <cassert>
+
+// The longest transmission that is recorded, in seconds
+const unsigned int PARROT_TIMEOUT = 180U;
+
+// The longest transmission that is recorded when spilling to disk, in seconds
+const unsigned int PARROT_SPILL_TIMEOUT = 900U;
+
+CParrotWorker::CParrotWorker(unsigned short port, bool reusePort, unsigned int budget, unsigned int maxSessions, const std::string& spill) :
+CThread(),
+m_network(port, reusePort),
+m_pool(budget),
+m_maxSessions(maxSessions),
+m_spill(spill),
+m_timeout(spill.empty() ? PARROT_TIMEOUT : PARROT_SPILL_TIMEOUT),
+m_sessions()
+{
+	assert(maxSessions > 0U);
+}
+
+CParrotWorker::~CParrotWorker()
+{
+	for (auto& it : m_sessions)
+		delete it.second;
+}
+
+bool CParrotWorker::open()
+{
+	return m_network.open();
+}
+
+void CParrotWorker::entry()
+{
+	CStopWatch stopWatch;
+	stopWatch.start();
+
+	for (;;) {
+		unsigned char buffer[200U];
+		sockaddr_storage addr;
+		unsigned int addrLen;
+
+		// Each client is recorded and played back on its own
+		unsigned int len;
+		while ((len = m_network.read(buffer, addr, addrLen)) > 0U) {
+			CAddressKey key = CAddressKey::create(addr, addrLen);
+
+			std::unordered_map<CAddressKey, CSession*, CAddressKeyHash>::iterator it = m_sessions.find(key);
+			if (it != m_sessions.end()) {
+				it->second->write(buffer, len);
+			} else if (m_sessions.size() < m_maxSessions) {
+				CSession* session = new CSession(addr, addrLen, m_pool, m_timeout, m_spill);
+				session->write(buffer, len);
+				m_sessions[key] = session;
+			}
+		}
+
+		unsigned int ms = stopWatch.elapsed();
+		stopWatch.start();
+
+		// Wake for the next frame due exactly, but still read the network at least every 5ms
+		uint64_t deadline = CFrameClock::now() + 5000000ULL;
+
+		for (std::unordered_map<CAddressKey, CSession*, CAddressKeyHash>::iterator it = m_sessions.begin(); it != m_sessions.end();) {
+			CSession* session = it->second;
+
+			session->clock(m_network, ms);
+
+			if (session->isIdle()) {
+				delete session;
+				it = m_sessions.erase(it);
+			} else {
+				uint64_t next = session->getDeadline();
+				if ((next != 0U) && (next < deadline))
+					deadline = next;
+				++it;
+			}
+		}
+
+		CFrameClock::sleepUntil(deadline);
+	}
+
+	m_network.close();
+}
@@ -0,0 +1,52 @@
+/*
+ *   Copyright (C) 2026 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(ParrotWorker_H)
+#define	ParrotWorker_H
+
+#include "AddressKey.h"
+#include "FramePool.h"
+#include "Session.h"
+#include "Network.h"
+#include "Thread.h"
+
+#include <unordered_map>
+#include <string>
+
+// One socket on the parrot port with its own clients and its own share of the
+// recording memory. When there is more than one, the kernel always passes the
+// datagrams from a client to the same worker, so nothing is shared between them.
+class CParrotWorker : public CThread {
+public:
+	CParrotWorker(unsigned short port, bool reusePort, unsigned int budget, unsigned int maxSessions, const std::string& spill);
+	virtual ~CParrotWorker();
+
+	bool open();
+
+	virtual void entry();
+
+private:
+	CNetwork     m_network;
+	CFramePool   m_pool;
+	unsigned int m_maxSessions;
+	std::string  m_spill;
+	unsigned int m_timeout;
+	std::unordered_map<CAddressKey, CSession*, CAddressKeyHash> m_sessions;
+};
+
+#endif
@@ -0,0 +1,109 @@
+/*
+ *   Copyright (C) 2026 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include "Session.h"
+
+#include <cstdio>
+#include <cassert>
+
+// How long a session is kept after its last transmission has been played back
+const unsigned int SESSION_IDLE_TIME = 60U;
+
+CSession::CSession(const sockaddr_storage& addr, unsigned int addrLen, CFramePool& pool, unsigned int timeout, const std::string& spill) :
+m_addr(addr),
+m_addrLen(addrLen),
+m_parrot(pool, timeout, spill),
+m_watchdogTimer(1000U, 0U, 1500U),
+m_turnaroundTimer(1000U, 2U),
+m_idleTimer(1000U, SESSION_IDLE_TIME),
+m_playoutClock(20U),
+m_playing(false)
+{
+	assert(addrLen > 0U);
+
+	m_idleTimer.start();
+}
+
+CSession::~CSession()
+{
+}
+
+void CSession::write(const unsigned char* data, unsigned int length)
+{
+	assert(data != nullptr);
+
+	m_parrot.write(data, length);
+	m_watchdogTimer.start();
+	m_idleTimer.start();
+
+	if (data[0U] == 0x80U) {
+		m_turnaroundTimer.start();
+		m_watchdogTimer.stop();
+		m_parrot.end();
+	}
+}
+
+void CSession::clock(CNetwork& network, unsigned int ms)
+{
+	if (m_turnaroundTimer.isRunning() && m_turnaroundTimer.hasExpired()) {
+		if (!m_playing) {
+			m_playoutClock.start();
+			m_playing = true;
+		}
+
+		while (m_playing && m_playoutClock.isDue()) {
+			unsigned char buffer[200U];
+			unsigned int len = m_parrot.read(buffer);
+			if (len > 0U) {
+				network.write(buffer, len, m_addr, m_addrLen);
+				m_playoutClock.tick();
+			} else {
+				m_parrot.clear();
+				m_turnaroundTimer.stop();
+				m_playoutClock.stop();
+				m_idleTimer.start();
+				m_playing = false;
+
+				::fprintf(stdout, "Played back %u frames, jitter mean %u us, max %u us\n", m_playoutClock.getFrames(), m_playoutClock.getMeanJitter(), m_playoutClock.getMaxJitter());
+			}
+		}
+	}
+
+	m_watchdogTimer.clock(ms);
+	m_turnaroundTimer.clock(ms);
+	m_idleTimer.clock(ms);
+
+	if (m_watchdogTimer.isRunning() && m_watchdogTimer.hasExpired()) {
+		m_turnaroundTimer.start();
+		m_watchdogTimer.stop();
+		m_parrot.end();
+	}
+}
+
+uint64_t CSession::getDeadline() const
+{
+	return m_playing ? m_playoutClock.getDeadline() : 0U;
+}
+
+bool CSession::isIdle()
+{
+	if (m_playing || m_watchdogTimer.isRunning() || m_turnaroundTimer.isRunning())
+		return false;
+
+	return m_idleTimer.isRunning() && m_idleTimer.hasExpired();
+}
@@ -0,0 +1,59 @@
+/*
+ *   Copyright (C) 2026 by Jonathan Naylor G4KLX
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#if !defined(Session_H)
+#define	Session_H
+
+#include "FrameClock.h"
+#include "Network.h"
+#include "Parrot.h"
+#include "Timer.h"
+
+#include <cstdint>
+#include <string>
+
+// One client of the parrot, with its own recording and timers, so that
+// any number of clients can be recorded and played back at the same time
+class CSession {
+public:
+	CSession(const sockaddr_storage& addr, unsigned int addrLen, CFramePool& pool, unsigned int timeout, const std::string& spill);
+	~CSession();
+
+	void write(const unsigned char* data, unsigned int length);
+
+	// Runs the timers and sends any frames of the playback that are due
+	void clock(CNetwork& network, unsigned int ms);
+
+	// When the next frame of the playback is due, or zero
+	uint64_t getDeadline() const;
+
+	// True once nothing has been heard or played back for a while
+	bool isIdle();
+
+private:
+	sockaddr_storage m_addr;
+	unsigned int     m_addrLen;
+	CParrot          m_parrot;
+	CTimer           m_watchdogTimer;
+	CTimer           m_turnaroundTimer;
+	CTimer           m_idleTimer;
+	CFrameClock      m_playoutClock;
+	bool             m_playing;
+};
+
+#endif
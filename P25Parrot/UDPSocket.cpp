@@ -1,5 +1,5 @@
 /*
- *   Copyright (C) 2006-2016,2020,2024,2025 by Jonathan Naylor G4KLX
+ *   Copyright (C) 2006-2016,2020,2024,2025,2026 by Jonathan Naylor G4KLX
  *
  *   This program is free software; you can redistribute it and/or modify
  *   it under the terms of the GNU General Public License as published by
@@ -36,6 +36,7 @@
 CUDPSocket::CUDPSocket(const std::string& address, unsigned short port) :
 m_localAddress(address),
 m_localPort(port),
+m_reusePort(false),
 #if defined(_WIN32) || defined(_WIN64)
 m_fd(INVALID_SOCKET),
 #else
@@ -48,6 +49,7 @@ m_af(AF_UNSPEC)
 CUDPSocket::CUDPSocket(unsigned short port) :
 m_localAddress(),
 m_localPort(port),
+m_reusePort(false),
 #if defined(_WIN32) || defined(_WIN64)
 m_fd(INVALID_SOCKET),
 #else
@@ -154,6 +156,11 @@ bool CUDPSocket::match(const sockaddr_storage& addr1, const sockaddr_storage& ad
 	}
 }
 
+void CUDPSocket::setReusePort(bool reuse)
+{
+	m_reusePort = reuse;
+}
+
 bool CUDPSocket::open(const sockaddr_storage& address)
 {
 	m_af = address.ss_family;
@@ -196,6 +203,12 @@ bool CUDPSocket::open()
 		return false;
 	}
 
+#if defined(_WIN32) || defined(_WIN64)
+	// There is no MSG_DONTWAIT on Windows so make the socket itself non-blocking
+	u_long nonBlocking = 1UL;
+	::ioctlsocket(m_fd, FIONBIO, &nonBlocking);
+#endif
+
 	if (m_localPort > 0U) {
 		int reuse = 1;
 		if (::setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, (char *)&reuse, sizeof(reuse)) == -1) {
@@ -208,6 +221,14 @@ bool CUDPSocket::open()
 			return false;
 		}
 
+#if defined(SO_REUSEPORT)
+		if (m_reusePort && (::setsockopt(m_fd, SOL_SOCKET, SO_REUSEPORT, (char *)&reuse, sizeof(reuse)) == -1)) {
+			LogError("Cannot set the UDP socket reuse port option, err: %d", errno);
+			close();
+			return false;
+		}
+#endif
+
 		if (::bind(m_fd, (sockaddr*)&addr, addrlen) == -1) {
 #if defined(_WIN32) || defined(_WIN64)
 			LogError("Cannot bind the UDP address, err: %lu", ::GetLastError());
@@ -237,40 +258,21 @@ int CUDPSocket::read(unsigned char* buffer, unsigned int length, sockaddr_storag
 		return 0;
 #endif
 
-	// Check that the readfrom() won't block
-	struct pollfd pfd;
-	pfd.fd      = m_fd;
-	pfd.events  = POLLIN;
-	pfd.revents = 0;
-
-	// Return immediately
-#if defined(_WIN32) || defined(_WIN64)
-	int ret = WSAPoll(&pfd, 1, 0);
-#else
-	int ret = ::poll(&pfd, 1, 0);
-#endif
-	if (ret < 0) {
-#if defined(_WIN32) || defined(_WIN64)
-		LogError("Error returned from UDP poll, err: %lu", ::GetLastError());
-#else
-		LogError("Error returned from UDP poll, err: %d", errno);
-#endif
-		return -1;
-	}
-
-	if ((pfd.revents & POLLIN) == 0)
-		return 0;
-
 #if defined(_WIN32) || defined(_WIN64)
 	int size = sizeof(sockaddr_storage);
 #else
 	socklen_t size = sizeof(sockaddr_storage);
 #endif
 
+	// A single non-blocking receive, no data is reported as EAGAIN rather than an error
 #if defined(_WIN32) || defined(_WIN64)
 	int len = ::recvfrom(m_fd, (char*)buffer, length, 0, (sockaddr *)&address, &size);
+	if ((len < 0) && (::WSAGetLastError() == WSAEWOULDBLOCK))
+		return 0;
 #else
-	ssize_t len = ::recvfrom(m_fd, (char*)buffer, length, 0, (sockaddr *)&address, &size);
+	ssize_t len = ::recvfrom(m_fd, (char*)buffer, length, MSG_DONTWAIT, (sockaddr *)&address, &size);
+	if ((len < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+		return 0;
 #endif
 	if (len <= 0) {
 #if defined(_WIN32) || defined(_WIN64)
@@ -1,5 +1,5 @@
 /*
- *   Copyright (C) 2009-2011,2013,2015,2016,2020,2024,2025 by Jonathan Naylor G4KLX
+ *   Copyright (C) 2009-2011,2013,2015,2016,2020,2024,2025,2026 by Jonathan Naylor G4KLX
  *
  *   This program is free software; you can redistribute it and/or modify
  *   it under the terms of the GNU General Public License as published by
@@ -46,6 +46,10 @@ public:
 	CUDPSocket(unsigned short port = 0U);
 	~CUDPSocket();
 
+	// Lets several sockets bind the same port, the kernel spreads the datagrams
+	// between them by source address. Must be called before open().
+	void setReusePort(bool reuse);
+
 	bool open();
 	bool open(const sockaddr_storage& address);
 
@@ -65,6 +69,7 @@ public:
 private:
 	std::string    m_localAddress;
 	unsigned short m_localPort;
+	bool           m_reusePort;
 #if defined(_WIN32) || defined(_WIN64)
 	SOCKET         m_fd;
 	int            m_af;